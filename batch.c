@@ -0,0 +1,147 @@
+#include "batch.h"
+#include <ctype.h>
+#include <stdbool.h>
+#include <dirent.h>
+#include <glob.h>
+#include <string.h>
+#include <sys/stat.h>
+
+static int batch_push(struct Batch *b, const char *path)
+{
+	if (b->n == b->cap) {
+		const size_t cap = b->cap ? b->cap * 2 : 64;
+		struct Batch_File *files = realloc(b->files, cap * sizeof(*files));
+		if (!files)
+			return -1;
+		b->files = files;
+		b->cap = cap;
+	}
+	b->files[b->n].path = strdup(path);
+	if (!b->files[b->n].path)
+		return -1;
+	b->files[b->n].seq = replication_seq(path);
+	b->n++;
+	return 0;
+}
+
+static bool has_suffix(const char *s, const char *suffix)
+{
+	const size_t n = strlen(s), m = strlen(suffix);
+	return n >= m && strcmp(s + n - m, suffix) == 0;
+}
+
+/* OSM XML, optionally compressed. Skips the state.txt files that sit next to replication diffs. */
+static bool is_osm_file(const char *name)
+{
+	static const char *const exts[] = {".osc", ".osm", ".osc.gz", ".osm.gz", ".osc.bz2", ".osm.bz2"};
+	for (size_t i = 0; i < sizeof(exts) / sizeof(*exts); i++)
+		if (has_suffix(name, exts[i]))
+			return true;
+	return false;
+}
+
+/* Add every OSM file under `dir`, recursing into the <AAA>/<BBB> replication directories. */
+static int batch_add_dir(struct Batch *b, const char *dir)
+{
+	DIR *d = opendir(dir);
+	if (!d)
+		return -1;
+	int r = 0;
+	const struct dirent *e;
+	while (r == 0 && (e = readdir(d)) != NULL) {
+		if (e->d_name[0] == '.')
+			continue;
+		char path[4096];
+		snprintf(path, sizeof(path), "%s/%s", dir, e->d_name);
+		struct stat st;
+		if (stat(path, &st) != 0)
+			continue;
+		if (S_ISDIR(st.st_mode))
+			r = batch_add_dir(b, path);
+		else if (is_osm_file(e->d_name))
+			r = batch_push(b, path);
+	}
+	closedir(d);
+	return r;
+}
+
+/* Add `path`: a file, a directory of them, or a glob pattern (quoted, or too many matches for argv).
+ * Returns 0 on success, -1 if nothing could be added. */
+int batch_add(struct Batch *b, const char *path)
+{
+	if (strcmp(path, "-") == 0)
+		return batch_push(b, path); // stdin
+	struct stat st;
+	if (stat(path, &st) == 0)
+		return S_ISDIR(st.st_mode) ? batch_add_dir(b, path) : batch_push(b, path);
+
+	glob_t g;
+	if (glob(path, 0, NULL, &g) != 0)
+		return -1;
+	int r = 0;
+	for (size_t i = 0; r == 0 && i < g.gl_pathc; i++)
+		r = batch_add(b, g.gl_pathv[i]);
+	globfree(&g);
+	return r;
+}
+
+/* Add the paths listed one per line in `list`. */
+int batch_read_list(struct Batch *b, FILE *list)
+{
+	char line[4096];
+	while (fgets(line, sizeof(line), list)) {
+		line[strcspn(line, "\r\n")] = '\0';
+		if (line[0] == '\0')
+			continue;
+		if (batch_add(b, line) != 0)
+			return -1;
+	}
+	return 0;
+}
+
+static int compare_files(const void *a, const void *b)
+{
+	const struct Batch_File *fa = a, *fb = b;
+	if (fa->seq != fb->seq)
+		return fa->seq < fb->seq ? -1 : 1; // Files without a sequence number go first.
+	return strcmp(fa->path, fb->path);
+}
+
+/* Order the files by replication sequence number, so later diffs are applied after earlier ones. */
+void batch_sort(struct Batch *b)
+{
+	qsort(b->files, b->n, sizeof(*b->files), compare_files);
+}
+
+void batch_free(struct Batch *b)
+{
+	for (size_t i = 0; i < b->n; i++)
+		free(b->files[i].path);
+	free(b->files);
+	b->files = NULL;
+	b->n = b->cap = 0;
+}
+
+static bool three_digits(const char *p)
+{
+	return isdigit(p[0]) && isdigit(p[1]) && isdigit(p[2]);
+}
+
+/* Replication diffs are published as <AAA>/<BBB>/<CCC>.osc.gz for sequence number AAABBBCCC,
+ * dl.py saves them flat as <seq>.osc.gz. Returns -1 for anything else. */
+long long replication_seq(const char *path)
+{
+	const char *base = strrchr(path, '/');
+	base = base ? base + 1 : path;
+	if (!isdigit(base[0]))
+		return -1;
+	char *end;
+	long long seq = strtoll(base, &end, 10);
+	if (*end != '.' && *end != '\0')
+		return -1;
+
+	if (end - base == 3 && base - path >= 8 && base[-1] == '/' && base[-5] == '/' &&
+	    three_digits(base - 4) && three_digits(base - 8) && (base - path == 8 || base[-9] == '/'))
+		seq += strtoll(base - 8, NULL, 10) * 1000000 + strtoll(base - 4, NULL, 10) * 1000;
+	return seq;
+}
@@ -0,0 +1,31 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+struct Batch_File
+{
+	char *path;
+	long long seq; // Replication sequence number, -1 if the path doesn't carry one.
+};
+
+/* Input files for one run of the loader, loaded in replication order. */
+struct Batch
+{
+	struct Batch_File *files;
+	size_t n;
+	size_t cap;
+};
+
+int batch_add(struct Batch *b, const char *path);
+
+int batch_read_list(struct Batch *b, FILE *list);
+
+void batch_sort(struct Batch *b);
+
+void batch_free(struct Batch *b);
+
+long long replication_seq(const char *path);
+
+#endif
@@ -0,0 +1,344 @@
+#include "bunzip.h"
+#include <bzlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+/* Every bzip2 block starts with the BCD digits of pi and every stream ends with those of sqrt(pi),
+ * neither of them byte aligned. */
+#define BLOCK_MAGIC 0x314159265359ULL
+#define EOS_MAGIC 0x177245385090ULL
+#define MAGIC_BITS 48
+#define MAGIC_MASK ((1ULL << MAGIC_BITS) - 1)
+
+/* Pages behind the oldest block in flight are dropped in steps of this size. */
+#define RELEASE_STEP (32 * 1048576)
+
+enum Bunzip_Status
+{
+	EMPTY,
+	SCANNED,
+	DECODING,
+	DECODED,
+	FAILED,
+	ABSORBED // Merged into an earlier block that failed on its own.
+};
+
+struct Bunzip_Block
+{
+	uint64_t start; // Bit offset of the block header.
+	uint64_t end;	// Bit offset of whatever header follows it.
+	uint32_t crc;
+	enum Bunzip_Status status;
+	char *out;
+	size_t len;
+	size_t cap;
+};
+
+/* Values the third byte of a 64-bit window can take when a header starts in its first byte. */
+static bool candidate[256];
+
+static void *worker(void *arg);
+
+static uint64_t load_be64(const unsigned char *data, const size_t size, const size_t p)
+{
+	uint64_t w = 0;
+	if (p + 8 <= size) {
+		memcpy(&w, data + p, 8);
+		return __builtin_bswap64(w);
+	}
+	for (size_t k = 0; k < 8; k++)
+		w = (w << 8) | (p + k < size ? data[p + k] : 0);
+	return w;
+}
+
+/* Bit offset of the first block or end-of-stream header at or after `from`, UINT64_MAX if there is none. */
+static uint64_t find_magic(const struct Bunzip *bz, const uint64_t from, bool *eos)
+{
+	for (size_t p = from / 8; p + MAGIC_BITS / 8 <= bz->size; p++) {
+		if (!candidate[bz->data[p + 2]])
+			continue;
+		const uint64_t w = load_be64(bz->data, bz->size, p);
+		for (int shift = 0; shift < 8; shift++) {
+			const uint64_t c = (w >> (64 - MAGIC_BITS - shift)) & MAGIC_MASK;
+			if ((c == BLOCK_MAGIC || c == EOS_MAGIC) && p * 8 + shift >= from) {
+				*eos = c == EOS_MAGIC;
+				return p * 8 + shift;
+			}
+		}
+	}
+	return UINT64_MAX;
+}
+
+/* Find the bit range of the next block into `b`. Returns false once there are no more. */
+static bool scan_block(struct Bunzip *bz, struct Bunzip_Block *b)
+{
+	// Skip over end-of-stream markers, multi-stream files just carry on with the next header.
+	while (bz->magic != UINT64_MAX && bz->magic_eos)
+		bz->magic = find_magic(bz, bz->magic + MAGIC_BITS, &bz->magic_eos);
+	if (bz->magic == UINT64_MAX)
+		return false;
+
+	b->start = bz->magic;
+	b->crc = load_be64(bz->data, bz->size, (b->start + MAGIC_BITS) / 8) >> (32 - (b->start + MAGIC_BITS) % 8);
+	bz->magic = find_magic(bz, b->start + MAGIC_BITS, &bz->magic_eos);
+	b->end = bz->magic != UINT64_MAX ? bz->magic : bz->size * 8;
+	return true;
+}
+
+static void put_bits(unsigned char *buf, uint64_t pos, const uint64_t val, const int count)
+{
+	for (int i = count - 1; i >= 0; i--, pos++) {
+		if ((val >> i) & 1)
+			buf[pos / 8] |= 0x80 >> (pos % 8);
+		else
+			buf[pos / 8] &= ~(0x80 >> (pos % 8));
+	}
+}
+
+/* Decode bits [start, end) as a stand-alone stream: a header, the block(s), and an end-of-stream
+ * marker whose combined CRC is just the CRC of the one block. */
+static bool decode(const struct Bunzip *bz, const uint64_t start, const uint64_t end, const uint32_t crc, struct Bunzip_Block *b)
+{
+	const uint64_t n_bits = end - start;
+	const size_t wrap_len = 4 + (n_bits + MAGIC_BITS + 32 + 7) / 8;
+	unsigned char *wrap = calloc(wrap_len, 1);
+	if (!wrap)
+		return false;
+	memcpy(wrap, "BZh9", 4); // The largest block size, whatever the original used.
+
+	const size_t from = start / 8;
+	const int shift = start % 8;
+	const size_t n_bytes = (n_bits + 7) / 8;
+	for (size_t k = 0; k < n_bytes; k++) {
+		const unsigned hi = bz->data[from + k] << shift;
+		const unsigned lo = shift && from + k + 1 < bz->size ? bz->data[from + k + 1] >> (8 - shift) : 0;
+		wrap[4 + k] = hi | lo;
+	}
+	put_bits(wrap, 32 + n_bits, EOS_MAGIC, MAGIC_BITS);
+	put_bits(wrap, 32 + n_bits + MAGIC_BITS, crc, 32);
+
+	bz_stream s;
+	memset(&s, 0, sizeof(s));
+	bool ok = BZ2_bzDecompressInit(&s, 0, 0) == BZ_OK;
+	s.next_in = (char *)wrap;
+	s.avail_in = wrap_len;
+	b->len = 0;
+	while (ok) {
+		if (b->len == b->cap) {
+			const size_t cap = b->cap ? b->cap * 2 : HUGE_PAGE_BYTES;
+			char *out = huge_alloc(cap, bz->huge);
+			if (!out) {
+				ok = false;
+				break;
+			}
+			memcpy(out, b->out, b->len);
+			huge_free(b->out, b->cap, bz->huge);
+			b->out = out;
+			b->cap = cap;
+		}
+		s.next_out = b->out + b->len;
+		s.avail_out = b->cap - b->len;
+		const int r = BZ2_bzDecompress(&s);
+		b->len = b->cap - s.avail_out;
+		if (r == BZ_STREAM_END)
+			break;
+		if (r != BZ_OK || (s.avail_in == 0 && s.avail_out > 0))
+			ok = false;
+	}
+	BZ2_bzDecompressEnd(&s);
+	free(wrap);
+	return ok;
+}
+
+/* Decode the `data` of a mapped bzip2 file with `n_workers` threads. */
+struct Bunzip *bunzip_new(const char *data, const size_t size, const int n_workers, const enum Huge_Pages huge)
+{
+	for (int shift = 0; shift < 8; shift++) {
+		candidate[((BLOCK_MAGIC << (64 - MAGIC_BITS - shift)) >> 40) & 0xff] = true;
+		candidate[((EOS_MAGIC << (64 - MAGIC_BITS - shift)) >> 40) & 0xff] = true;
+	}
+
+	struct Bunzip *bz = calloc(1, sizeof(*bz));
+	if (!bz)
+		return NULL;
+	bz->data = (const unsigned char *)data;
+	bz->size = size;
+	bz->huge = huge;
+	bz->magic = find_magic(bz, 0, &bz->magic_eos);
+
+	// Enough blocks in flight to keep every worker busy while the parser drains the oldest.
+	bz->window = 2 * n_workers;
+	bz->blocks = calloc(bz->window, sizeof(*bz->blocks));
+	bz->workers = calloc(n_workers, sizeof(*bz->workers));
+	if (!bz->blocks || !bz->workers) {
+		free(bz->blocks);
+		free(bz->workers);
+		free(bz);
+		return NULL;
+	}
+	pthread_mutex_init(&bz->lock, NULL);
+	pthread_cond_init(&bz->work, NULL);
+	pthread_cond_init(&bz->done, NULL);
+	for (bz->n_workers = 0; bz->n_workers < n_workers; bz->n_workers++)
+		if (pthread_create(&bz->workers[bz->n_workers], NULL, worker, bz) != 0)
+			break;
+	if (bz->n_workers == 0) {
+		bunzip_free(bz);
+		return NULL;
+	}
+	return bz;
+}
+
+static struct Bunzip_Block *slot(const struct Bunzip *bz, const size_t n)
+{
+	return &bz->blocks[n % bz->window];
+}
+
+static void *worker(void *arg)
+{
+	struct Bunzip *bz = arg;
+	pthread_mutex_lock(&bz->lock);
+	for (;;) {
+		while (!bz->stop && bz->next_decode == bz->next_scan)
+			pthread_cond_wait(&bz->work, &bz->lock);
+		if (bz->stop)
+			break;
+		struct Bunzip_Block *b = slot(bz, bz->next_decode++);
+		b->status = DECODING;
+		pthread_mutex_unlock(&bz->lock);
+
+		const bool ok = decode(bz, b->start, b->end, b->crc, b);
+
+		pthread_mutex_lock(&bz->lock);
+		b->status = ok ? DECODED : FAILED;
+		pthread_cond_broadcast(&bz->done);
+	}
+	pthread_mutex_unlock(&bz->lock);
+	return NULL;
+}
+
+/* Queue blocks until the window is full. Called with `lock` held. */
+static void fill_window(struct Bunzip *bz)
+{
+	while (!bz->scan_done && bz->next_scan - bz->next_out < bz->window) {
+		// Only this thread touches slots at or past `next_scan`, scan without holding up the workers.
+		struct Bunzip_Block *b = slot(bz, bz->next_scan);
+		pthread_mutex_unlock(&bz->lock);
+		const bool found = scan_block(bz, b);
+		pthread_mutex_lock(&bz->lock);
+		if (!found) {
+			bz->scan_done = true;
+			break;
+		}
+		b->status = SCANNED;
+		bz->next_scan++;
+		pthread_cond_signal(&bz->work);
+	}
+}
+
+static void wait_decoded(struct Bunzip *bz, const struct Bunzip_Block *b)
+{
+	while (b->status == SCANNED || b->status == DECODING)
+		pthread_cond_wait(&bz->done, &bz->lock);
+}
+
+/* The oldest block failed to decode, most likely because compressed data inside it looked like a header
+ * and cut it short. Retry with that header treated as data, absorbing any blocks found inside.
+ * Called with `lock` held. */
+static bool merge(struct Bunzip *bz)
+{
+	struct Bunzip_Block *b = slot(bz, bz->next_out);
+	uint64_t end = b->end;
+	for (int k = 0; k < BUNZIP_MAX_MERGE && end < bz->size * 8; k++) {
+		bool eos;
+		end = find_magic(bz, end + 1, &eos);
+		if (end == UINT64_MAX)
+			end = bz->size * 8;
+
+		pthread_mutex_unlock(&bz->lock);
+		const bool ok = decode(bz, b->start, end, b->crc, b);
+		pthread_mutex_lock(&bz->lock);
+		if (!ok)
+			continue;
+
+		for (size_t n = bz->next_out + 1; n < bz->next_scan && slot(bz, n)->start < end; n++) {
+			// Wait for the worker to let go of it, its output is thrown away.
+			wait_decoded(bz, slot(bz, n));
+			slot(bz, n)->status = ABSORBED;
+		}
+		if (bz->magic < end)
+			bz->magic = find_magic(bz, end, &bz->magic_eos);
+		b->status = DECODED;
+		return true;
+	}
+	return false;
+}
+
+/* The parser is done with the oldest block, free its slot and drop the input it came from. */
+static void retire(struct Bunzip *bz)
+{
+	do {
+		slot(bz, bz->next_out)->status = EMPTY;
+		bz->next_out++;
+	} while (bz->next_out < bz->next_scan && slot(bz, bz->next_out)->status == ABSORBED);
+	bz->out_pos = 0;
+
+	if (bz->next_out < bz->next_scan) {
+		const size_t upto = (slot(bz, bz->next_out)->start / 8) & ~(sysconf(_SC_PAGESIZE) - 1);
+		if (upto - bz->released >= RELEASE_STEP) {
+			madvise((void *)(bz->data + bz->released), upto - bz->released, MADV_DONTNEED);
+			bz->released = upto;
+		}
+	}
+}
+
+/* Copy up to `cap` decompressed bytes into `out`, in file order. Returns 0 at the end of the file
+ * or on error, in which case `failed` is set. */
+size_t bunzip_read(struct Bunzip *bz, char *out, const size_t cap)
+{
+	size_t n = 0;
+	pthread_mutex_lock(&bz->lock);
+	while (n < cap && !bz->failed) {
+		fill_window(bz);
+		if (bz->next_out == bz->next_scan)
+			break;
+
+		struct Bunzip_Block *b = slot(bz, bz->next_out);
+		wait_decoded(bz, b);
+		if (b->status == FAILED && !merge(bz)) {
+			bz->failed = true;
+			break;
+		}
+
+		size_t take = b->len - bz->out_pos;
+		if (take > cap - n)
+			take = cap - n;
+		memcpy(out + n, b->out + bz->out_pos, take);
+		n += take;
+		bz->out_pos += take;
+		if (bz->out_pos == b->len)
+			retire(bz);
+	}
+	pthread_mutex_unlock(&bz->lock);
+	return n;
+}
+
+void bunzip_free(struct Bunzip *bz)
+{
+	pthread_mutex_lock(&bz->lock);
+	bz->stop = true;
+	pthread_cond_broadcast(&bz->work);
+	pthread_mutex_unlock(&bz->lock);
+	for (int i = 0; i < bz->n_workers; i++)
+		pthread_join(bz->workers[i], NULL);
+
+	pthread_mutex_destroy(&bz->lock);
+	pthread_cond_destroy(&bz->work);
+	pthread_cond_destroy(&bz->done);
+	for (size_t i = 0; i < bz->window; i++)
+		huge_free(bz->blocks[i].out, bz->blocks[i].cap, bz->huge);
+	free(bz->blocks);
+	free(bz->workers);
+	free(bz);
+}
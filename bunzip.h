@@ -0,0 +1,52 @@
+#ifndef BUNZIP_H
+#define BUNZIP_H
+
+#include "hugepage.h"
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/* A block that fails to decode is retried with up to this many of the headers that ended it
+ * treated as data, in case they were compressed bits that happened to look like one. */
+#define BUNZIP_MAX_MERGE 4
+
+struct Bunzip_Block;
+
+/* Decodes the blocks of a mapped bzip2 file on a pool of worker threads. */
+struct Bunzip
+{
+	const unsigned char *data;
+	size_t size;
+	bool failed;
+
+	// Scanner (consumer thread only)
+	uint64_t magic;	  // Bit offset of the next header found but not yet used, UINT64_MAX if none.
+	bool magic_eos;	  // It was an end-of-stream marker rather than a block.
+	bool scan_done;
+	size_t released;
+
+	// Shared, under `lock`
+	struct Bunzip_Block *blocks; // `window` slots, block `n` lives in slot `n % window`.
+	size_t window;
+	size_t next_scan;   // Blocks [next_out, next_scan) have been found.
+	size_t next_decode; // Blocks [next_out, next_decode) have been taken by a worker.
+	size_t next_out;    // Oldest block the parser has not finished with.
+	size_t out_pos;	    // Bytes of it already handed out.
+	bool stop;
+	enum Huge_Pages huge; // For the decoded block buffers.
+
+	pthread_t *workers;
+	int n_workers;
+	pthread_mutex_t lock;
+	pthread_cond_t work;
+	pthread_cond_t done;
+};
+
+struct Bunzip *bunzip_new(const char *data, size_t size, int n_workers, enum Huge_Pages huge);
+
+size_t bunzip_read(struct Bunzip *bz, char *out, size_t cap);
+
+void bunzip_free(struct Bunzip *bz);
+
+#endif
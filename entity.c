@@ -0,0 +1,96 @@
+#include "entity.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+/* Write code point `c` as UTF-8. Returns its length, 0 if it isn't a character XML allows. */
+static size_t utf8_encode(char *out, const uint32_t c)
+{
+	if (c == 0 || (c >= 0xD800 && c <= 0xDFFF) || c > 0x10FFFF)
+		return 0;
+	if (c < 0x80) {
+		out[0] = c;
+		return 1;
+	}
+	if (c < 0x800) {
+		out[0] = 0xC0 | c >> 6;
+		out[1] = 0x80 | (c & 0x3F);
+		return 2;
+	}
+	if (c < 0x10000) {
+		out[0] = 0xE0 | c >> 12;
+		out[1] = 0x80 | (c >> 6 & 0x3F);
+		out[2] = 0x80 | (c & 0x3F);
+		return 3;
+	}
+	out[0] = 0xF0 | c >> 18;
+	out[1] = 0x80 | (c >> 12 & 0x3F);
+	out[2] = 0x80 | (c >> 6 & 0x3F);
+	out[3] = 0x80 | (c & 0x3F);
+	return 4;
+}
+
+/* The text of entity `name` (between '&' and ';') into `out`. Returns its length, 0 if unknown. */
+static size_t entity_text(char *out, const char *name, const size_t len)
+{
+	if (len >= 2 && name[0] == '#') {
+		const bool hex = name[1] == 'x';
+		if (len == 1 + hex || len > 1 + hex + 7)
+			return 0;
+		uint32_t c = 0;
+		for (size_t i = 1 + hex; i < len; i++) {
+			const char d = name[i];
+			if (d >= '0' && d <= '9')
+				c = c * (hex ? 16 : 10) + (d - '0');
+			else if (hex && (d | 0x20) >= 'a' && (d | 0x20) <= 'f')
+				c = c * 16 + ((d | 0x20) - 'a' + 10);
+			else
+				return 0;
+		}
+		return utf8_encode(out, c);
+	}
+
+	static const struct
+	{
+		const char *name;
+		char c;
+	} predefined[] = {{"amp", '&'}, {"lt", '<'}, {"gt", '>'}, {"quot", '"'}, {"apos", '\''}};
+	for (size_t i = 0; i < sizeof(predefined) / sizeof(*predefined); i++) {
+		if (strlen(predefined[i].name) == len && memcmp(predefined[i].name, name, len) == 0) {
+			*out = predefined[i].c;
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/* Copy `len` bytes of attribute text from `src` to `dst` with the predefined entities and character
+ * references replaced. Anything that doesn't parse as one is copied as it is. Output beyond `cap`
+ * bytes is dropped. Returns the length written. */
+size_t entity_decode(char *dst, const size_t cap, const char *src, const size_t len)
+{
+	size_t n = 0;
+	for (size_t i = 0; i < len;) {
+		char text[4];
+		size_t text_len = 0, used = 1;
+		if (src[i] == '&') {
+			// Longest is "&#x10FFFF;"
+			const char *semi = memchr(src + i + 1, ';', len - i - 1 < 9 ? len - i - 1 : 9);
+			if (semi) {
+				text_len = entity_text(text, src + i + 1, semi - (src + i + 1));
+				if (text_len > 0)
+					used = semi + 1 - (src + i);
+			}
+		}
+		if (text_len == 0) {
+			text[0] = src[i];
+			text_len = 1;
+		}
+		if (n + text_len > cap)
+			break;
+		memcpy(dst + n, text, text_len);
+		n += text_len;
+		i += used;
+	}
+	return n;
+}
@@ -0,0 +1,8 @@
+#ifndef ENTITY_H
+#define ENTITY_H
+
+#include <stdlib.h>
+
+size_t entity_decode(char *dst, size_t cap, const char *src, size_t len);
+
+#endif
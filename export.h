@@ -0,0 +1,8 @@
+#ifndef EXPORT_H
+#define EXPORT_H
+
+/* The library is built with -fvisibility=hidden, so only what's marked with this is exported from
+ * liblighthouse.so. */
+#define LH_EXPORT __attribute__((visibility("default")))
+
+#endif
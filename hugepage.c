@@ -0,0 +1,40 @@
+#include "hugepage.h"
+#include <sys/mman.h>
+
+static size_t round_up(const size_t size)
+{
+	return (size + HUGE_PAGE_BYTES - 1) & ~(size_t)(HUGE_PAGE_BYTES - 1);
+}
+
+/* A page-aligned buffer of `size` bytes, backed by 2 MB pages where `mode` asks for it
+ * and the kernel has them. Release with `huge_free` and the same `size` and `mode`. */
+void *huge_alloc(const size_t size, const enum Huge_Pages mode)
+{
+	if (mode == HUGE_PAGES_OFF) {
+		void *p;
+		return posix_memalign(&p, 4096, size) == 0 ? p : NULL;
+	}
+
+	const size_t len = round_up(size);
+	void *p;
+	if (mode == HUGE_PAGES_HUGETLB) {
+		p = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+		if (p != MAP_FAILED)
+			return p;
+	}
+	p = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (p == MAP_FAILED)
+		return NULL;
+	madvise(p, len, MADV_HUGEPAGE);
+	return p;
+}
+
+void huge_free(void *p, const size_t size, const enum Huge_Pages mode)
+{
+	if (!p)
+		return;
+	if (mode == HUGE_PAGES_OFF)
+		free(p);
+	else
+		munmap(p, round_up(size));
+}
@@ -0,0 +1,19 @@
+#ifndef HUGEPAGE_H
+#define HUGEPAGE_H
+
+#include <stdlib.h>
+
+#define HUGE_PAGE_BYTES (2 * 1048576)
+
+enum Huge_Pages
+{
+	HUGE_PAGES_OFF,
+	HUGE_PAGES_THP,	    // Transparent huge pages, via madvise(MADV_HUGEPAGE).
+	HUGE_PAGES_HUGETLB, // Reserved pages (vm.nr_hugepages), falling back to THP if there are none.
+};
+
+void *huge_alloc(size_t size, enum Huge_Pages mode);
+
+void huge_free(void *p, size_t size, enum Huge_Pages mode);
+
+#endif
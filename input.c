@@ -0,0 +1,527 @@
+#define _GNU_SOURCE // O_DIRECT
+#include "input.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+static size_t raw_next(struct Input *in, const char **chunk);
+static size_t gzip_fill(struct Input *in, char *out, size_t cap);
+static size_t bzip2_fill(struct Input *in, char *out, size_t cap);
+static size_t bunzip_fill(struct Input *in, char *out, size_t cap);
+static size_t read_fill(struct Input *in, char *out, size_t cap);
+static int ring_start(struct Input *in, size_t (*fill)(struct Input *, char *, size_t));
+static size_t ring_next(struct Input *in, const char **chunk);
+static void ring_stop(struct Input *in);
+static void prefetch_start(struct Input *in);
+static void prefetch_advance(struct Input *in, size_t cursor);
+static void prefetch_stop(struct Input *in);
+
+/* Read until `buf` is full or the input ends, pipes hand out at most a page or so per read. A read
+ * error sets `in->failed` and ends the input there. */
+static size_t read_full(struct Input *in, char *buf, const size_t cap)
+{
+	size_t n = 0;
+	while (n < cap && !in->failed) {
+		const ssize_t r = read(in->fd, buf + n, cap - n);
+		if (r == 0)
+			break;
+		if (r < 0) {
+			if (errno == EINTR)
+				continue;
+			in->failed = true;
+			break;
+		}
+		n += r;
+	}
+	return n;
+}
+
+static unsigned long long now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static enum Input_Codec sniff_codec(const unsigned char *p, const size_t n)
+{
+	if (n >= 2 && p[0] == 0x1f && p[1] == 0x8b)
+		return CODEC_GZIP;
+	if (n >= 3 && p[0] == 'B' && p[1] == 'Z' && p[2] == 'h')
+		return CODEC_BZIP2;
+	return CODEC_NONE;
+}
+
+/* Open `path` ("-" for stdin) for chunked reading. Regular files are mapped, anything else (pipes,
+ * character devices) is read through a fixed `INPUT_CHUNK` buffer. gzip and bzip2
+ * input is recognised by its magic bytes and decompressed on a separate thread,
+ * mapped bzip2 files on a worker per core. With `INPUT_ASYNC`, plain input is read
+ * ahead on a thread instead (optionally `INPUT_DIRECT`). A non-zero `prefetch` keeps that
+ * many bytes ahead of the reader in the page cache.
+ * Returns 0 on success, -1 on failure. */
+int input_open(struct Input *in, const char *path, const int flags, const size_t prefetch)
+{
+	memset(in, 0, sizeof(*in));
+	// "-" is stdin. dup() it so closing works the same as for a path.
+	in->fd = strcmp(path, "-") == 0 ? dup(STDIN_FILENO) : open(path, O_RDONLY);
+	if (in->fd < 0)
+		return -1;
+
+	in->prefetch.window = prefetch;
+	if (flags & INPUT_HUGETLB)
+		in->huge = HUGE_PAGES_HUGETLB;
+	else if (flags & INPUT_THP)
+		in->huge = HUGE_PAGES_THP;
+
+	struct stat st;
+	if (fstat(in->fd, &st) < 0)
+		goto fail;
+
+	if (S_ISREG(st.st_mode)) {
+		in->mapped = true;
+		in->size = st.st_size;
+		if (in->size > 0) {
+			void *p = mmap(NULL, in->size, PROT_READ, MAP_PRIVATE, in->fd, 0);
+			if (p == MAP_FAILED)
+				goto fail;
+			// We walk the bytes exactly once, front to back.
+			madvise(p, in->size, MADV_SEQUENTIAL);
+			if (in->huge != HUGE_PAGES_OFF)
+				madvise(p, in->size, MADV_HUGEPAGE); // Only takes on tmpfs and THP-enabled page caches.
+			in->data = p;
+		}
+		in->codec = sniff_codec((const unsigned char *)in->data, in->size);
+	} else {
+		in->raw = huge_alloc(INPUT_CHUNK, in->huge);
+		if (!in->raw)
+			goto fail;
+		// Can't seek back on a pipe, so the sniffed bytes are kept for the first `raw_next`.
+		in->pending = read_full(in, in->raw, INPUT_CHUNK);
+		in->codec = sniff_codec((const unsigned char *)in->raw, in->pending);
+	}
+
+	switch (in->codec) {
+	case CODEC_NONE:
+		if (!(flags & INPUT_ASYNC)) {
+			prefetch_start(in);
+			return 0;
+		}
+		if (in->mapped) {
+			// Keep INPUT_RING reads in flight instead of faulting pages in as the parser goes.
+			if (in->data)
+				munmap((void *)in->data, in->size);
+			in->data = NULL;
+			in->mapped = false;
+			if (flags & INPUT_DIRECT)
+				fcntl(in->fd, F_SETFL, fcntl(in->fd, F_GETFL) | O_DIRECT);
+		}
+		if (ring_start(in, read_fill) == 0)
+			return 0;
+		break;
+	case CODEC_GZIP:
+		// 15 window bits, +32 to accept both gzip and zlib headers.
+		if (inflateInit2(&in->z, 15 + 32) != Z_OK)
+			goto fail;
+		if (ring_start(in, gzip_fill) == 0)
+			return 0;
+		inflateEnd(&in->z);
+		break;
+	case CODEC_BZIP2:
+		if (in->mapped) {
+			in->bunzip = bunzip_new(in->data, in->size, sysconf(_SC_NPROCESSORS_ONLN), in->huge);
+			if (!in->bunzip)
+				goto fail;
+			if (ring_start(in, bunzip_fill) == 0)
+				return 0;
+			bunzip_free(in->bunzip);
+			break;
+		}
+		if (BZ2_bzDecompressInit(&in->bz, 0, 0) != BZ_OK)
+			goto fail;
+		if (ring_start(in, bzip2_fill) == 0)
+			return 0;
+		BZ2_bzDecompressEnd(&in->bz);
+		break;
+	}
+
+fail:
+	if (in->data)
+		munmap((void *)in->data, in->size);
+	huge_free(in->raw, INPUT_CHUNK, in->huge);
+	close(in->fd);
+	return -1;
+}
+
+/* Drop the mapped pages behind `cursor` so RSS stays flat. */
+static void input_release(struct Input *in, const size_t cursor)
+{
+	const size_t page = sysconf(_SC_PAGESIZE);
+	const size_t upto = cursor & ~(page - 1);
+	madvise((char *)in->data + in->released, upto - in->released, MADV_DONTNEED);
+	in->released = upto;
+}
+
+/* Next run of bytes exactly as they are stored, 0 at end of input. */
+static size_t raw_next(struct Input *in, const char **chunk)
+{
+	if (in->mapped) {
+		if (in->offset - in->released >= INPUT_RELEASE_STEP)
+			input_release(in, in->offset);
+		size_t n = in->size - in->offset;
+		if (n > INPUT_CHUNK)
+			n = INPUT_CHUNK;
+		*chunk = in->data + in->offset;
+		in->offset += n;
+		prefetch_advance(in, in->offset);
+		return n;
+	}
+
+	size_t n;
+	if (in->pending > 0) {
+		n = in->pending;
+		in->pending = 0;
+	} else {
+		const unsigned long long start = now_ns();
+		n = read_full(in, in->raw, INPUT_CHUNK);
+		in->wait_ns += now_ns() - start;
+	}
+	*chunk = in->raw;
+	in->offset += n;
+	return n;
+}
+
+/* Point `chunk` at the next run of (decompressed) input bytes and return its length,
+ * 0 at end of input. The chunk stays valid until the next call. */
+size_t input_next(struct Input *in, const char **chunk)
+{
+	if (!in->ring.fill)
+		return raw_next(in, chunk);
+	return ring_next(in, chunk);
+}
+
+/* Inflate into `out` until it is full. Concatenated gzip members are read back to back. */
+static size_t gzip_fill(struct Input *in, char *out, const size_t cap)
+{
+	z_stream *z = &in->z;
+	z->next_out = (Bytef *)out;
+	z->avail_out = cap;
+	while (z->avail_out > 0) {
+		if (z->avail_in == 0) {
+			const char *p;
+			const size_t n = raw_next(in, &p);
+			if (n == 0) {
+				if (z->total_in > 0) {
+					fprintf(stderr, "gzip: unexpected end of input\n");
+					in->failed = true;
+				}
+				break;
+			}
+			z->next_in = (Bytef *)p;
+			z->avail_in = n;
+		}
+		const int r = inflate(z, Z_NO_FLUSH);
+		if (r == Z_STREAM_END) {
+			inflateReset(z);
+		} else if (r != Z_OK) {
+			fprintf(stderr, "gzip: %s\n", z->msg ? z->msg : "corrupt input");
+			in->failed = true;
+			break;
+		}
+	}
+	return cap - z->avail_out;
+}
+
+/* bzip2 counterpart of `gzip_fill`, multi-stream files (pbzip2 et al.) included. */
+static size_t bzip2_fill(struct Input *in, char *out, const size_t cap)
+{
+	bz_stream *bz = &in->bz;
+	bz->next_out = out;
+	bz->avail_out = cap;
+	while (bz->avail_out > 0) {
+		if (bz->avail_in == 0) {
+			const char *p;
+			const size_t n = raw_next(in, &p);
+			if (n == 0) {
+				if (bz->total_in_lo32 > 0 || bz->total_in_hi32 > 0) {
+					fprintf(stderr, "bzip2: unexpected end of input\n");
+					in->failed = true;
+				}
+				break;
+			}
+			bz->next_in = (char *)p;
+			bz->avail_in = n;
+		}
+		const int r = BZ2_bzDecompress(bz);
+		if (r == BZ_STREAM_END) {
+			// Keep the unread input across the re-init.
+			char *next_in = bz->next_in;
+			const unsigned avail_in = bz->avail_in;
+			char *next_out = bz->next_out;
+			const unsigned avail_out = bz->avail_out;
+			BZ2_bzDecompressEnd(bz);
+			memset(bz, 0, sizeof(*bz));
+			BZ2_bzDecompressInit(bz, 0, 0);
+			bz->next_in = next_in;
+			bz->avail_in = avail_in;
+			bz->next_out = next_out;
+			bz->avail_out = avail_out;
+		} else if (r != BZ_OK) {
+			fprintf(stderr, "bzip2: corrupt input (%d)\n", r);
+			in->failed = true;
+			break;
+		}
+	}
+	return cap - bz->avail_out;
+}
+
+static size_t bunzip_fill(struct Input *in, char *out, const size_t cap)
+{
+	const size_t n = bunzip_read(in->bunzip, out, cap);
+	// The scanner is the furthest anything has read into the file.
+	prefetch_advance(in, in->bunzip->magic != UINT64_MAX ? in->bunzip->magic / 8 : in->size);
+	if (in->bunzip->failed && !in->failed) {
+		fprintf(stderr, "bzip2: corrupt input\n");
+		in->failed = true;
+	}
+	return n;
+}
+
+/* Plain reads for `INPUT_ASYNC`, into buffers aligned for O_DIRECT (`huge_alloc` is page aligned). */
+static size_t read_fill(struct Input *in, char *out, const size_t cap)
+{
+	if (in->pending > 0) {
+		const size_t n = in->pending;
+		memcpy(out, in->raw, n);
+		in->pending = 0;
+		in->offset += n;
+		return n;
+	}
+	const size_t n = read_full(in, out, cap);
+	in->offset += n;
+	prefetch_advance(in, in->offset);
+	return n;
+}
+
+static void *ring_producer(void *arg)
+{
+	struct Input *in = arg;
+	struct Ring *r = &in->ring;
+	for (;;) {
+		pthread_mutex_lock(&r->lock);
+		while (r->head - r->tail == INPUT_RING && !r->closing)
+			pthread_cond_wait(&r->not_full, &r->lock);
+		if (r->closing) {
+			pthread_mutex_unlock(&r->lock);
+			break;
+		}
+		char *buf = r->bufs[r->head % INPUT_RING];
+		pthread_mutex_unlock(&r->lock);
+
+		const size_t n = r->fill(in, buf, INPUT_CHUNK);
+		// Once `fill` has failed, calling it again would only report the same error twice.
+		const bool last = n == 0 || in->failed;
+
+		pthread_mutex_lock(&r->lock);
+		if (n > 0) {
+			r->lens[r->head % INPUT_RING] = n;
+			r->head++;
+		}
+		if (last)
+			r->done = true;
+		pthread_cond_signal(&r->not_empty);
+		pthread_mutex_unlock(&r->lock);
+		if (last)
+			break;
+	}
+	return NULL;
+}
+
+/* Run `fill` on its own thread, so producing chunks overlaps with parsing them. */
+static int ring_start(struct Input *in, size_t (*fill)(struct Input *, char *, size_t))
+{
+	struct Ring *r = &in->ring;
+	r->fill = fill;
+	for (size_t i = 0; i < INPUT_RING; i++) {
+		r->bufs[i] = huge_alloc(INPUT_CHUNK, in->huge);
+		if (!r->bufs[i])
+			goto fail;
+	}
+	pthread_mutex_init(&r->lock, NULL);
+	pthread_cond_init(&r->not_empty, NULL);
+	pthread_cond_init(&r->not_full, NULL);
+	prefetch_start(in); // Before the producer can report progress to it.
+	if (pthread_create(&r->thread, NULL, ring_producer, in) == 0)
+		return 0;
+
+	pthread_mutex_destroy(&r->lock);
+	pthread_cond_destroy(&r->not_empty);
+	pthread_cond_destroy(&r->not_full);
+fail:
+	for (size_t i = 0; i < INPUT_RING; i++)
+		huge_free(r->bufs[i], INPUT_CHUNK, in->huge);
+	r->fill = NULL;
+	return -1;
+}
+
+static size_t ring_next(struct Input *in, const char **chunk)
+{
+	struct Ring *r = &in->ring;
+	size_t n = 0;
+	pthread_mutex_lock(&r->lock);
+	if (r->held) {
+		// The parser is done with the previous chunk, hand its slot back.
+		r->tail++;
+		r->held = false;
+		pthread_cond_signal(&r->not_full);
+	}
+	if (r->head == r->tail && !r->done) {
+		const unsigned long long start = now_ns();
+		while (r->head == r->tail && !r->done)
+			pthread_cond_wait(&r->not_empty, &r->lock);
+		in->wait_ns += now_ns() - start;
+	}
+	if (r->head != r->tail) {
+		*chunk = r->bufs[r->tail % INPUT_RING];
+		n = r->lens[r->tail % INPUT_RING];
+		r->held = true;
+	}
+	pthread_mutex_unlock(&r->lock);
+	return n;
+}
+
+static void ring_stop(struct Input *in)
+{
+	struct Ring *r = &in->ring;
+	pthread_mutex_lock(&r->lock);
+	r->closing = true;
+	pthread_cond_signal(&r->not_full);
+	pthread_mutex_unlock(&r->lock);
+	pthread_join(r->thread, NULL);
+
+	pthread_mutex_destroy(&r->lock);
+	pthread_cond_destroy(&r->not_empty);
+	pthread_cond_destroy(&r->not_full);
+	for (size_t i = 0; i < INPUT_RING; i++)
+		huge_free(r->bufs[i], INPUT_CHUNK, in->huge);
+}
+
+static void *prefetcher(void *arg)
+{
+	struct Input *in = arg;
+	struct Prefetch *pf = &in->prefetch;
+	const size_t page = sysconf(_SC_PAGESIZE);
+	pthread_mutex_lock(&pf->lock);
+	while (!pf->stop) {
+		size_t target = pf->cursor + pf->window;
+		if (target > in->size)
+			target = in->size;
+		// Wait for the reader to eat into the window, rather than chasing every chunk.
+		if (target <= pf->done || (target - pf->done < pf->window / 4 && target < in->size)) {
+			pthread_cond_wait(&pf->wake, &pf->lock);
+			continue;
+		}
+		const size_t from = (pf->done > pf->cursor ? pf->done : pf->cursor) & ~(page - 1);
+		pthread_mutex_unlock(&pf->lock);
+
+		if (in->mapped)
+			madvise((char *)in->data + from, target - from, MADV_WILLNEED);
+		else
+			readahead(in->fd, from, target - from); // Blocks until read, hence the thread.
+
+		pthread_mutex_lock(&pf->lock);
+		pf->done = target;
+	}
+	pthread_mutex_unlock(&pf->lock);
+	return NULL;
+}
+
+/* Keep the next `window` bytes of a regular file in the page cache, from a helper thread, so
+ * whoever reads the raw input doesn't stall on major faults. Pipes and O_DIRECT reads are left alone. */
+static void prefetch_start(struct Input *in)
+{
+	struct Prefetch *pf = &in->prefetch;
+	if (pf->window == 0 || pf->running)
+		return;
+	if (in->size == 0 || (!in->mapped && (fcntl(in->fd, F_GETFL) & O_DIRECT))) {
+		pf->window = 0;
+		return;
+	}
+	pthread_mutex_init(&pf->lock, NULL);
+	pthread_cond_init(&pf->wake, NULL);
+	if (pthread_create(&pf->thread, NULL, prefetcher, in) == 0) {
+		pf->running = true;
+	} else {
+		pf->window = 0;
+		pthread_mutex_destroy(&pf->lock);
+		pthread_cond_destroy(&pf->wake);
+	}
+}
+
+static void prefetch_advance(struct Input *in, const size_t cursor)
+{
+	struct Prefetch *pf = &in->prefetch;
+	if (!pf->running)
+		return;
+	pthread_mutex_lock(&pf->lock);
+	pf->cursor = cursor;
+	pthread_cond_signal(&pf->wake);
+	pthread_mutex_unlock(&pf->lock);
+}
+
+static void prefetch_stop(struct Input *in)
+{
+	struct Prefetch *pf = &in->prefetch;
+	if (!pf->running)
+		return;
+	pf->running = false;
+	pthread_mutex_lock(&pf->lock);
+	pf->stop = true;
+	pthread_cond_signal(&pf->wake);
+	pthread_mutex_unlock(&pf->lock);
+	pthread_join(pf->thread, NULL);
+	pthread_mutex_destroy(&pf->lock);
+	pthread_cond_destroy(&pf->wake);
+}
+
+const char *input_codec_name(const enum Input_Codec codec)
+{
+	switch (codec) {
+	case CODEC_GZIP:
+		return "gzip";
+	case CODEC_BZIP2:
+		return "bzip2";
+	default:
+		return "plain";
+	}
+}
+
+void input_close(struct Input *in)
+{
+	switch (in->codec) {
+	case CODEC_NONE:
+		if (in->ring.fill)
+			ring_stop(in);
+		break;
+	case CODEC_GZIP:
+		ring_stop(in);
+		inflateEnd(&in->z);
+		break;
+	case CODEC_BZIP2:
+		ring_stop(in);
+		if (in->mapped)
+			bunzip_free(in->bunzip);
+		else
+			BZ2_bzDecompressEnd(&in->bz);
+		break;
+	}
+	prefetch_stop(in); // After the producers, they report progress to it.
+	if (in->data)
+		munmap((void *)in->data, in->size);
+	huge_free(in->raw, INPUT_CHUNK, in->huge);
+	close(in->fd);
+}
@@ -0,0 +1,99 @@
+#ifndef INPUT_H
+#define INPUT_H
+
+#include "bunzip.h"
+#include "hugepage.h"
+#include <bzlib.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <zlib.h>
+
+/* The parser is fed this much at a time, whatever the input size. */
+#define INPUT_CHUNK (4 * 1048576)
+/* Pages behind the parser cursor are dropped in steps of this size. */
+#define INPUT_RELEASE_STEP (32 * 1048576)
+/* Chunks a producer thread may run ahead of the parser. */
+#define INPUT_RING 4
+
+enum Input_Flags
+{
+	INPUT_ASYNC = 1,  // Read plain input on a thread instead of mapping it.
+	INPUT_DIRECT = 2, // ...with O_DIRECT, bypassing the page cache.
+	INPUT_THP = 4,	  // Back buffers (and the mapping, where the filesystem allows) with huge pages.
+	INPUT_HUGETLB = 8 // ...reserved ones, if there are any.
+};
+
+enum Input_Codec
+{
+	CODEC_NONE,
+	CODEC_GZIP,
+	CODEC_BZIP2
+};
+
+struct Input;
+
+/* Hands chunks from a producer thread to the parser, in order. */
+struct Ring
+{
+	char *bufs[INPUT_RING];
+	size_t lens[INPUT_RING];
+	size_t head; // Next slot the producer fills.
+	size_t tail; // Next slot the parser takes.
+	bool held;   // The parser still has `tail`.
+	bool done;
+	bool closing;
+	size_t (*fill)(struct Input *in, char *buf, size_t cap);
+	pthread_t thread;
+	pthread_mutex_t lock;
+	pthread_cond_t not_empty;
+	pthread_cond_t not_full;
+};
+
+/* Warms the page cache a fixed window ahead of where the input is being read. */
+struct Prefetch
+{
+	size_t window; // 0 when off.
+	size_t cursor; // Raw bytes consumed so far.
+	size_t done;   // Prefetched up to here.
+	bool running;
+	bool stop;
+	pthread_t thread;
+	pthread_mutex_t lock;
+	pthread_cond_t wake;
+};
+
+struct Input
+{
+	int fd;
+	bool mapped;
+	const char *data; // The whole file when mapped.
+	size_t size;	  // 0 when not known up front (pipes).
+	size_t offset;	  // Raw bytes handed out so far.
+	size_t released;
+	char *raw;	  // Read buffer when not mapped.
+	size_t pending;	  // Bytes already sitting in `raw` from sniffing the codec.
+	enum Huge_Pages huge;
+	bool failed;
+	unsigned long long wait_ns; // Time `input_next` spent blocked on a read or the producer thread.
+
+	enum Input_Codec codec;
+	union
+	{
+		z_stream z;
+		bz_stream bz;
+		struct Bunzip *bunzip; // Mapped bzip2 files are decoded block-parallel.
+	};
+	struct Ring ring;
+	struct Prefetch prefetch;
+};
+
+int input_open(struct Input *in, const char *path, int flags, size_t prefetch);
+
+size_t input_next(struct Input *in, const char **chunk);
+
+const char *input_codec_name(enum Input_Codec codec);
+
+void input_close(struct Input *in);
+
+#endif
@@ -0,0 +1,104 @@
+#include "intern.h"
+#include <string.h>
+
+#define INTERN_MIN_CAP 1024
+
+/* Mix 8 bytes at a time, enough to spread short keys like "highway" over the table. */
+uint64_t intern_hash(const char *str, const size_t len)
+{
+	uint64_t h = 0x9E3779B97F4A7C15 ^ len;
+	size_t i = 0;
+	for (; i + 8 <= len; i += 8) {
+		uint64_t v;
+		memcpy(&v, str + i, 8);
+		h = (h ^ v) * 0xFF51AFD7ED558CCD;
+		h ^= h >> 32;
+	}
+	uint64_t v = 0;
+	if (len > i)
+		memcpy(&v, str + i, len - i);
+	h = (h ^ v) * 0xC4CEB9FE1A85EC53;
+	h ^= h >> 29;
+	return h | 1; // 0 marks an empty slot
+}
+
+void intern_init(struct Intern *in)
+{
+	in->cap = INTERN_MIN_CAP;
+	in->n = 0;
+	in->slots = calloc(in->cap, sizeof(*in->slots));
+}
+
+/* The id `str` was put with. Returns false if it isn't cached. */
+bool intern_get(const struct Intern *in, const char *str, const size_t len, int64_t *id)
+{
+	const uint64_t h = intern_hash(str, len);
+	for (size_t i = h & (in->cap - 1);; i = (i + 1) & (in->cap - 1)) {
+		const struct Intern_Slot *s = &in->slots[i];
+		if (s->hash == 0)
+			return false;
+		if (s->hash == h && s->len == len && memcmp(s->str, str, len) == 0) {
+			*id = s->id;
+			return true;
+		}
+	}
+}
+
+static void intern_clear(struct Intern *in)
+{
+	for (size_t i = 0; i < in->cap; i++)
+		free(in->slots[i].str);
+	memset(in->slots, 0, in->cap * sizeof(*in->slots));
+	in->n = 0;
+}
+
+/* Twice the slots, rehashing what's there. */
+static void intern_grow(struct Intern *in)
+{
+	struct Intern_Slot *old = in->slots;
+	const size_t old_cap = in->cap;
+	in->cap *= 2;
+	in->slots = calloc(in->cap, sizeof(*in->slots));
+	for (size_t j = 0; j < old_cap; j++) {
+		if (old[j].hash == 0)
+			continue;
+		size_t i = old[j].hash & (in->cap - 1);
+		while (in->slots[i].hash != 0)
+			i = (i + 1) & (in->cap - 1);
+		in->slots[i] = old[j];
+	}
+	free(old);
+}
+
+/* Cache `str` -> `id`, replacing the id it had if it's cached already. `str` is copied. */
+void intern_put(struct Intern *in, const char *str, const size_t len, const int64_t id)
+{
+	if (in->n >= INTERN_MAX_ENTRIES)
+		intern_clear(in);
+	else if (2 * (in->n + 1) > in->cap) // At most half full, probes stay short
+		intern_grow(in);
+
+	const uint64_t h = intern_hash(str, len);
+	size_t i = h & (in->cap - 1);
+	for (; in->slots[i].hash != 0; i = (i + 1) & (in->cap - 1)) {
+		if (in->slots[i].hash == h && in->slots[i].len == len && memcmp(in->slots[i].str, str, len) == 0) {
+			in->slots[i].id = id;
+			return;
+		}
+	}
+	struct Intern_Slot *s = &in->slots[i];
+	s->hash = h;
+	s->str = malloc(len > 0 ? len : 1);
+	memcpy(s->str, str, len);
+	s->len = len;
+	s->id = id;
+	in->n++;
+}
+
+void intern_free(struct Intern *in)
+{
+	intern_clear(in);
+	free(in->slots);
+	in->slots = NULL;
+	in->cap = 0;
+}
@@ -0,0 +1,38 @@
+#ifndef INTERN_H
+#define INTERN_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/* Entries a cache holds before it's emptied and starts over, so that memory stays bounded however
+ * many distinct strings go through it. */
+#define INTERN_MAX_ENTRIES (1 << 22)
+
+struct Intern_Slot
+{
+	uint64_t hash; // 0 when empty
+	char *str;
+	size_t len;
+	int64_t id;
+};
+
+/* A cache of string -> id, open addressing with linear probing. */
+struct Intern
+{
+	struct Intern_Slot *slots;
+	size_t cap; // A power of two
+	size_t n;
+};
+
+uint64_t intern_hash(const char *str, size_t len);
+
+void intern_init(struct Intern *in);
+
+bool intern_get(const struct Intern *in, const char *str, size_t len, int64_t *id);
+
+void intern_put(struct Intern *in, const char *str, size_t len, int64_t id);
+
+void intern_free(struct Intern *in);
+
+#endif
@@ -0,0 +1,62 @@
+#include "lighthouse.h"
+#include "parser.h"
+
+struct LH_Parser
+{
+	struct Parser p;
+};
+
+/* A parser at the start of a document, or at `split` of one if it isn't NULL. `cb` is copied,
+ * `ctx` is passed to each callback as it is. Returns NULL if it couldn't be allocated. */
+static struct LH_Parser *parser_new(const enum LH_Parser_Mode mode, const struct LH_Split *split,
+				    const struct LH_Callbacks *cb, void *ctx)
+{
+	struct LH_Parser *lh = malloc(sizeof(*lh));
+	if (!lh)
+		return NULL;
+	if (split)
+		parser_init_split(&lh->p, split);
+	else
+		parser_init(&lh->p);
+	lh->p.mode = mode;
+	lh->p.cb = *cb;
+	lh->p.ctx = ctx;
+	return lh;
+}
+
+struct LH_Parser *lh_parser_new(const enum LH_Parser_Mode mode, const struct LH_Callbacks *cb, void *ctx)
+{
+	return parser_new(mode, NULL, cb, ctx);
+}
+
+/* A parser for one of the runs `lh_split_input` cut a document into, fed from `split->offset` on.
+ * Runs can be parsed independently, e.g. one per thread, each with its own parser. */
+struct LH_Parser *lh_parser_new_split(const enum LH_Parser_Mode mode, const struct LH_Split *split,
+				      const struct LH_Callbacks *cb, void *ctx)
+{
+	return parser_new(mode, split, cb, ctx);
+}
+
+/* Parse the next `len` bytes of the document. Chunks can be cut anywhere; the callbacks run for
+ * each entity as soon as its element closes. Returns 0, or -1 once the parser has run out of
+ * memory: it drops the rest of the input, finishing fails. */
+int lh_parser_feed(struct LH_Parser *lh, const char *buf, const size_t len)
+{
+	return parser_feed(&lh->p, buf, len);
+}
+
+/* Call at the end of the input. Returns false if it stopped mid-tag or with elements still open,
+ * i.e. the document (or split) was cut short and what was left of it has been dropped, or if it
+ * ran out of memory. */
+bool lh_parser_finish(const struct LH_Parser *lh)
+{
+	return parser_finish(&lh->p);
+}
+
+void lh_parser_free(struct LH_Parser *lh)
+{
+	if (!lh)
+		return;
+	parser_free(&lh->p);
+	free(lh);
+}
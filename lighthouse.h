@@ -0,0 +1,107 @@
+#ifndef LIGHTHOUSE_H
+#define LIGHTHOUSE_H
+
+#include "export.h"
+#include "slice.h"
+#include "split.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+enum LH_Parser_Mode
+{
+	LH_PARSER_SCALAR,	// Byte-at-a-time state machine.
+	LH_PARSER_INDEXED	// SIMD structural index, then a walk over it.
+};
+
+enum LH_Element_Type
+{
+	LH_NODE,
+	LH_WAY,
+	LH_RELATION,
+	LH_CHANGESET,
+	LH_CHANGESET_TAG,
+	LH_ELEMENT_TAG,
+	LH_WAY_ND,
+	LH_RELATION_MEMBER,
+	LH_NOT
+};
+
+/* The .osc block an element is in. The values are what the loader stores. */
+enum LH_Action
+{
+	LH_ACTION_NONE,	// A plain .osm file
+	LH_ACTION_CREATE,
+	LH_ACTION_MODIFY,
+	LH_ACTION_DELETE
+};
+
+struct LH_Member
+{
+	enum LH_Element_Type type; // LH_NODE, LH_WAY or LH_RELATION, LH_NOT for anything else
+	long ref;
+	struct LH_Slice role;
+};
+
+struct LH_Element
+{
+	long id;
+	long version;
+	long changeset;
+	int64_t timestamp; // Seconds since 1970, 0 if missing
+	long uid;
+	struct LH_Slice user;
+	enum LH_Element_Type type;
+	bool located;	// Nodes only: lat/lon were given, which they aren't in a delete
+	int32_t lat;	// 1e-7 degrees, see COORD_SCALE
+	int32_t lon;
+	const long *refs; // Ways only: the node ids, in order
+	size_t n_refs;
+	const struct LH_Member *members; // Relations only
+	size_t n_members;
+};
+
+struct LH_Changeset
+{
+	long id;
+	struct LH_Slice created_at;
+	struct LH_Slice closed_at;
+	bool open;
+	struct LH_Slice user;
+	long uid;
+	int32_t min_lat; // 1e-7 degrees, see COORD_SCALE
+	int32_t max_lat;
+	int32_t min_lon;
+	int32_t max_lon;
+	long comments;
+};
+
+/* Where each entity goes once its element has closed. Slices in it are only valid for the call.
+ * `action` is the .osc block the element is in, LH_ACTION_NONE in a plain file.
+ * Any of them can be NULL to skip that kind of entity. */
+struct LH_Callbacks
+{
+	void (*changeset)(void *ctx, const struct LH_Changeset *cs);
+	void (*changeset_tag)(void *ctx, long changeset, struct LH_Slice k, struct LH_Slice v);
+	// A tag of a node, way or relation, before that element's own callback. `elem` has its id and
+	// version, `type` says which kind it is.
+	void (*tag)(void *ctx, enum LH_Element_Type type, const struct LH_Element *elem, struct LH_Slice k, struct LH_Slice v);
+	void (*node)(void *ctx, const struct LH_Element *node, enum LH_Action action);
+	void (*way)(void *ctx, const struct LH_Element *way, enum LH_Action action);
+	void (*relation)(void *ctx, const struct LH_Element *relation, enum LH_Action action);
+};
+
+struct LH_Parser;
+
+LH_EXPORT struct LH_Parser *lh_parser_new(enum LH_Parser_Mode mode, const struct LH_Callbacks *cb, void *ctx);
+
+LH_EXPORT struct LH_Parser *lh_parser_new_split(enum LH_Parser_Mode mode, const struct LH_Split *split,
+						const struct LH_Callbacks *cb, void *ctx);
+
+LH_EXPORT int lh_parser_feed(struct LH_Parser *lh, const char *buf, size_t len);
+
+LH_EXPORT bool lh_parser_finish(const struct LH_Parser *lh);
+
+LH_EXPORT void lh_parser_free(struct LH_Parser *lh);
+
+#endif
@@ -1,298 +1,445 @@
 #include "load.h"
-#include "fixed_stack.h"
+#include "batch.h"
+#include "input.h"
+#include "intern.h"
+#include "lighthouse.h"
+#include "nodestore.h"
+#include "parse_num.h"
+#include "refs.h"
 #include <assert.h>
 #include <sqlite3.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
-sqlite3_stmt *stmt_insert_node;
-sqlite3_stmt *stmt_insert_way;
-sqlite3_stmt *stmt_insert_relation;
-sqlite3_stmt *stmt_insert_changeset;
-sqlite3_stmt *stmt_insert_changeset_tag;
-
-enum State
+/* A dictionary table of (id, text), with the ids it's handed out recently cached. */
+struct Dict
 {
-	TAG,
-	ATTR_NAME,
-	ATTR_VAL,
-	AFTER_ATTR_VAL,
-	IDLE
+	struct Intern cache;
+	sqlite3_stmt *find;
+	sqlite3_stmt *add;
 };
 
-enum OSM_Element_Type
+/* Prepared inserts, the context of the parser callbacks. */
+struct Sql
 {
-	NODE,
-	WAY,
-	RELATION,
-	CHANGESET,
-	CHANGESET_TAG,
-	NOT
+	sqlite3_stmt *node;
+	sqlite3_stmt *way;
+	sqlite3_stmt *relation;
+	sqlite3_stmt *changeset;
+	sqlite3_stmt *changeset_tag;
+	sqlite3_stmt *node_way; // -r, NULL without
+	sqlite3_stmt *node_tag;
+	sqlite3_stmt *way_tag;
+	sqlite3_stmt *relation_tag;
+	struct Dict keys;
+	struct Dict vals;
+	sqlite3_stmt *user;
+	struct Intern users; // uid -> intern_hash of the name last stored for it
+	bool epoch_times;	// -t
+	struct Node_Store *nodes; // -n, NULL without
+	bool nodes_failed;
+	bool out_of_memory; // Parsing or encoding refs, the file fails
+	uint8_t *blob; // Encoded refs of the way or relation being inserted
+	size_t blob_cap;
 };
 
-struct OSM_Element
-{
-	long id;
-	long version;
-	long changeset;
-	char *action;
-	enum OSM_Element_Type type;
+static void sql_insert_node(void *ctx, const struct LH_Element *node, enum LH_Action action);
+static void sql_insert_way(void *ctx, const struct LH_Element *way, enum LH_Action action);
+static void sql_insert_relation(void *ctx, const struct LH_Element *relation, enum LH_Action action);
+static void sql_insert_changeset(void *ctx, const struct LH_Changeset *cs);
+static void sql_insert_changeset_tag(void *ctx, long changeset, struct LH_Slice k, struct LH_Slice v);
+static void sql_insert_tag(void *ctx, enum LH_Element_Type type, const struct LH_Element *elem, struct LH_Slice k,
+			   struct LH_Slice v);
+
+static const struct LH_Callbacks sql_callbacks = {
+	.changeset = sql_insert_changeset,
+	.changeset_tag = sql_insert_changeset_tag,
+	.tag = sql_insert_tag,
+	.node = sql_insert_node,
+	.way = sql_insert_way,
+	.relation = sql_insert_relation,
 };
 
-struct OSM_Changeset
+static void usage(const char *prog)
 {
-	long id;
-	char created_at[21];
-	char closed_at[21];
-	bool open;
-	char user[256];
-	long uid;
-	double min_lat;
-	double max_lat;
-	double min_lon;
-	double max_lon;
-	long comments;
-};
+	fprintf(stderr, "Usage: %s [-a] [-d] [-H thp|hugetlb] [-n <file>] [-p scalar|index] [-r] [-t] [-w <size>] [-l <list>] <input>... <db>\n"
+			"  <input> is a file, a directory of them, a glob pattern, or - for stdin\n"
+			"  -a  read plain input on a separate thread instead of mapping it\n"
+			"  -d  like -a, with O_DIRECT reads\n"
+			"  -H  back input buffers with transparent or reserved 2 MB pages\n"
+			"  -n  also store node locations in <file>, 8 bytes per node id\n"
+			"  -p  parse byte by byte (default) or from a SIMD index of the markup\n"
+			"  -r  also index which ways reference each node, in node_ways\n"
+			"  -t  store created_at/closed_at as integer seconds since 1970, not text\n"
+			"  -w  prefetch this far ahead of the parser, e.g. 64M (default off)\n"
+			"  -l  also load the files listed in <list>, one per line (- for stdin)\n",
+		prog);
+}
 
-int main(const int argc, char **argv)
+/* Parse one input file into the open transaction. Returns false if it couldn't be read. */
+static bool load_file(struct Sql *sql, const char *path, const int input_flags, const size_t prefetch,
+		      const enum LH_Parser_Mode mode)
 {
-	assert(argc == 3);
-
-	sqlite3 *db;
-	sqlite3_open(argv[2], &db);
-	sqlite3_exec(db, "BEGIN TRANSACTION;", NULL, NULL, NULL);
-
-	sqlite3_prepare_v2(db, "INSERT INTO nodes VALUES (?,?,?,?);", -1, &stmt_insert_node, NULL);
-	sqlite3_prepare_v2(db, "INSERT INTO ways VALUES (?,?,?,?);", -1, &stmt_insert_way, NULL);
-	sqlite3_prepare_v2(db, "INSERT INTO relations VALUES (?,?,?,?);", -1, &stmt_insert_relation, NULL);
-	sqlite3_prepare_v2(db, "INSERT INTO changesets VALUES (?,?,?,?,?,?,?,?,?,?,?);", -1, &stmt_insert_changeset, NULL);
-	sqlite3_prepare_v2(db, "INSERT INTO changeset_tags VALUES (?,?,?);", -1, &stmt_insert_changeset_tag, NULL);
-
-	FILE *file = fopen(argv[1], "r");
-	assert(file);
+	struct Input in;
+	if (input_open(&in, path, input_flags, prefetch) != 0) {
+		fprintf(stderr, "Failed to open %s\n", path);
+		return false;
+	}
 
-	fseek(file, 0L, SEEK_END);
-	const size_t file_size = ftell(file);
-	rewind(file);
+	const char *name = streq(path, "-") ? "stdin" : path;
+	char size_strbuf[256];
+	if (in.mapped)
+		parse_size(in.size, size_strbuf, 256);
+	else
+		snprintf(size_strbuf, 256, "a stream"); // Pipes: no size until it's all been read.
+	if (in.codec != CODEC_NONE)
+		printf("Loading %s of %s data from %s...\n", size_strbuf, input_codec_name(in.codec), name);
+	else
+		printf("Loading %s of data from %s...\n", size_strbuf, name);
 
-	char *buf = malloc(file_size);
+	struct LH_Parser *parser = lh_parser_new(mode, &sql_callbacks, sql);
+	if (!parser) {
+		fprintf(stderr, "Out of memory\n");
+		input_close(&in);
+		return false;
+	}
 
-	char size_strbuf[256];
-	parse_size(file_size, size_strbuf, 256);
-	printf("Loading %s of data...\n", size_strbuf);
-
-	fread(buf, 1, file_size, file);
-
-	enum State state = IDLE;
-	struct FixedStack tags;
-	fstack_init(&tags);
-	int sub_cursor = 0;
-	int skip = 0;
-	char tag_name[32] = {0};
-	bool start_tag = false;
-	char attr_name[128] = {0};
-	char attr_val[512] = {0};
-	char attr_val_k[512] = {0};
-
-	struct OSM_Element elem;
-	struct OSM_Changeset changeset;
-
-	printf("Parsing...\n");
-	for (size_t i = 0; i < file_size; i++) {
-		if (skip > 0) {
-			skip--;
-			continue;
-		}
-		const char c = buf[i];
+	const char *chunk;
+	size_t n;
+	while ((n = input_next(&in, &chunk)) > 0)
+		if (lh_parser_feed(parser, chunk, n) != 0)
+			sql->out_of_memory = true; // Keep reading, the producer thread waits on us
+	const bool complete = lh_parser_finish(parser);
+	lh_parser_free(parser);
+	input_close(&in);
+	if (in.failed) {
+		fprintf(stderr, "Failed to read %s\n", name);
+		return false;
+	}
+	if (sql->out_of_memory) {
+		fprintf(stderr, "Out of memory loading %s\n", name);
+		return false;
+	}
+	if (!complete) {
+		fprintf(stderr, "%s ends mid-element\n", name);
+		return false;
+	}
+	if (sql->nodes_failed) {
+		fprintf(stderr, "Failed to store node locations from %s\n", name);
+		return false;
+	}
+	printf("DONE (%.2fs waiting on input)\n", in.wait_ns / 1e9);
+	return true;
+}
 
-		switch (state) {
-		case IDLE:
-			if (c == '<') // <tag> || </tag>
-				state = TAG;
+int main(const int argc, char **argv)
+{
+	struct Sql sql = {0};
+	int input_flags = 0;
+	size_t prefetch = 0;
+	enum LH_Parser_Mode parser_mode = LH_PARSER_SCALAR;
+	const char *list_path = NULL;
+	const char *nodes_path = NULL;
+	bool node_ways = false;
+	int opt;
+	while ((opt = getopt(argc, argv, "adH:l:n:p:rtw:")) != -1) {
+		switch (opt) {
+		case 'a':
+			input_flags |= INPUT_ASYNC;
 			break;
-		case TAG:
-			switch (c) {
-			case ' ': // '<tag '
-				state = ATTR_NAME;
-				goto found_tag_name;
-			case '>': // <tag>
-				state = IDLE;
-				goto found_tag_name;
-			case '?': // <?
-				state = IDLE;
-				goto exit_tag_name;
-			case '/': // </tag>
-				start_tag = false;
-				break;
-			default:
-				tag_name[sub_cursor++] = c;
-				break;
-			}
+		case 'd':
+			input_flags |= INPUT_ASYNC | INPUT_DIRECT;
 			break;
-
-		found_tag_name:
-			if (start_tag)
-				fstack_push(&tags, tag_name, strlen(tag_name) + 1); // Start-tag '<tag>'
-
-			// Have to check what we're leaving in case of <changeset><tag /></changeset>
-			// At </changeset> elem will still be <tag.
-			char *top = fstack_top(&tags);
-			if (streq(top, "node"))
-				elem.type = NODE;
-			else if (streq(top, "way"))
-				elem.type = WAY;
-			else if (streq(top, "relation"))
-				elem.type = RELATION;
-			else if (streq(top, "changeset"))
-				elem.type = CHANGESET;
-			else if (streq(top, "tag") && streq(fstack_n(&tags, 1), "changeset"))
-				elem.type = CHANGESET_TAG;
-			else
-				elem.type = NOT;
-
-			if (!start_tag) {
-				// End-tag '</tag>' (we have had some markup in-between)
-				if (elem.type == NODE || elem.type == RELATION || elem.type == WAY)
-					sql_insert_elem(&elem, fstack_n(&tags, 1));
-				else if (elem.type == CHANGESET)
-					sql_insert_changeset(&changeset);
-				else if (elem.type == CHANGESET_TAG) // should never happen, these always self-close
-					sql_insert_changeset_tag(changeset.id, attr_val_k, attr_val);
-
-				fstack_down(&tags);
+		case 'H':
+			if (streq(optarg, "thp")) {
+				input_flags |= INPUT_THP;
+			} else if (streq(optarg, "hugetlb")) {
+				input_flags |= INPUT_HUGETLB;
+			} else {
+				usage(argv[0]);
+				return 1;
 			}
-			// fstack_print(&tags);
-		exit_tag_name:
-			tag_name[sub_cursor] = '\0';
-			sub_cursor = 0;
-			start_tag = true;
 			break;
-		case ATTR_NAME:
-			if (c == '=') {
-				// we have the name
-				attr_name[sub_cursor] = '\0';
-
-				sub_cursor = 0;
-				skip = 1; // Skip opening quote
-				state = ATTR_VAL;
-				break;
-			}
-			// Empty-element tags would be supported here but we won't.
-			// i.e. all nodes must have >= 1 attribute.
-			attr_name[sub_cursor++] = c;
+		case 'l':
+			list_path = optarg;
 			break;
-		case ATTR_VAL:
-			if (c == '"') {
-				// val and name acquired now
-				attr_val[sub_cursor] = '\0';
-
-				if (elem.type == NODE || elem.type == WAY || elem.type == RELATION) {
-					elem_attr_add(&elem, attr_name, attr_val);
-				} else if (elem.type == CHANGESET) {
-					changeset_attr_add(&changeset, attr_name, attr_val);
-				} else if (elem.type == CHANGESET_TAG && streq(attr_name, "k")) {
-					strcpy(attr_val_k, attr_val); // assume `v` is 2nd so leave it in attr_val.
-				}
-
-				sub_cursor = 0;
-				state = AFTER_ATTR_VAL;
-				break;
-			}
-			attr_val[sub_cursor++] = c;
+		case 'n':
+			nodes_path = optarg;
 			break;
-		case AFTER_ATTR_VAL:
-			if (c == ' ') {
-				state = ATTR_NAME;
-				break;
+		case 'p':
+			if (streq(optarg, "scalar")) {
+				parser_mode = LH_PARSER_SCALAR;
+			} else if (streq(optarg, "index")) {
+				parser_mode = LH_PARSER_INDEXED;
+			} else {
+				usage(argv[0]);
+				return 1;
 			}
-			if (c == '"')
-				break;
-			if (c == '/') {
-				// End-tag with no markup in-between
-				if (elem.type == NODE || elem.type == RELATION || elem.type == WAY)
-					sql_insert_elem(&elem, fstack_n(&tags, 1));
-				else if (elem.type == CHANGESET)
-					sql_insert_changeset(&changeset);
-				else if (elem.type == CHANGESET_TAG)
-					sql_insert_changeset_tag(changeset.id, attr_val_k, attr_val);
-
-				fstack_down(&tags);
+			break;
+		case 'r':
+			node_ways = true;
+			break;
+		case 't':
+			sql.epoch_times = true;
+			break;
+		case 'w':
+			if (parse_bytes(optarg, &prefetch) != 0) {
+				usage(argv[0]);
+				return 1;
 			}
-			state = IDLE;
 			break;
+		default:
+			usage(argv[0]);
+			return 1;
 		}
 	}
-	printf("DONE\n");
-	free(buf);
-	fclose(file);
+	if (argc - optind < (list_path ? 1 : 2)) {
+		usage(argv[0]);
+		return 1;
+	}
+	const char *db_path = argv[argc - 1];
+
+	struct Batch batch = {0};
+	bool stdin_input = false;
+	for (int i = optind; i < argc - 1; i++) {
+		stdin_input |= streq(argv[i], "-");
+		if (batch_add(&batch, argv[i]) != 0) {
+			fprintf(stderr, "No input at %s\n", argv[i]);
+			return 1;
+		}
+	}
+	if (list_path) {
+		if (streq(list_path, "-") && stdin_input) {
+			fprintf(stderr, "stdin can't be both the file list and an input\n");
+			return 1;
+		}
+		FILE *list = streq(list_path, "-") ? stdin : fopen(list_path, "r");
+		if (!list || batch_read_list(&batch, list) != 0) {
+			fprintf(stderr, "Failed to read the file list %s\n", list_path);
+			return 1;
+		}
+		if (list != stdin)
+			fclose(list);
+	}
+	batch_sort(&batch);
+
+	struct Node_Store nodes;
+	if (nodes_path) {
+		if (nodestore_open(&nodes, nodes_path) != 0) {
+			fprintf(stderr, "Failed to open the node store %s\n", nodes_path);
+			return 1;
+		}
+		sql.nodes = &nodes;
+	}
+
+	sqlite3 *db;
+	sqlite3_open(db_path, &db);
+	sqlite3_exec(db, "BEGIN TRANSACTION;", NULL, NULL, NULL);
+
+	sqlite3_prepare_v2(db, "INSERT INTO nodes VALUES (?,?,?,?,?,?);", -1, &sql.node, NULL);
+	sqlite3_prepare_v2(db, "INSERT INTO ways VALUES (?,?,?,?,?,?,?);", -1, &sql.way, NULL);
+	sqlite3_prepare_v2(db, "INSERT INTO relations VALUES (?,?,?,?,?,?,?);", -1, &sql.relation, NULL);
+	sqlite3_prepare_v2(db, "INSERT INTO changesets VALUES (?,?,?,?,?,?,?,?,?,?);", -1, &sql.changeset, NULL);
+	// Users rename, the name seen last wins.
+	sqlite3_prepare_v2(db, "INSERT OR REPLACE INTO users VALUES (?,?);", -1, &sql.user, NULL);
+	sqlite3_prepare_v2(db, "INSERT INTO changeset_tags VALUES (?,?,?);", -1, &sql.changeset_tag, NULL);
+	if (node_ways)
+		sqlite3_prepare_v2(db, "INSERT OR IGNORE INTO node_ways VALUES (?,?);", -1, &sql.node_way, NULL);
+	// A key repeated within an element (the API doesn't allow it, but files have them) takes the last value.
+	sqlite3_prepare_v2(db, "INSERT OR REPLACE INTO node_tags VALUES (?,?,?,?);", -1, &sql.node_tag, NULL);
+	sqlite3_prepare_v2(db, "INSERT OR REPLACE INTO way_tags VALUES (?,?,?,?);", -1, &sql.way_tag, NULL);
+	sqlite3_prepare_v2(db, "INSERT OR REPLACE INTO relation_tags VALUES (?,?,?,?);", -1, &sql.relation_tag, NULL);
+	sqlite3_prepare_v2(db, "SELECT id FROM keys WHERE k = ?;", -1, &sql.keys.find, NULL);
+	sqlite3_prepare_v2(db, "INSERT INTO keys (k) VALUES (?);", -1, &sql.keys.add, NULL);
+	sqlite3_prepare_v2(db, "SELECT id FROM vals WHERE v = ?;", -1, &sql.vals.find, NULL);
+	sqlite3_prepare_v2(db, "INSERT INTO vals (v) VALUES (?);", -1, &sql.vals.add, NULL);
+	intern_init(&sql.keys.cache);
+	intern_init(&sql.vals.cache);
+	intern_init(&sql.users);
+
+	// One transaction for the whole batch. A file that fails is rolled back and
+	// stops the run, the diffs before it are still committed so no gap is left.
+	bool ok = true;
+	for (size_t i = 0; i < batch.n && ok; i++) {
+		sqlite3_exec(db, "SAVEPOINT file;", NULL, NULL, NULL);
+		ok = load_file(&sql, batch.files[i].path, input_flags, prefetch, parser_mode);
+		if (!ok)
+			sqlite3_exec(db, "ROLLBACK TO file;", NULL, NULL, NULL);
+		sqlite3_exec(db, "RELEASE file;", NULL, NULL, NULL);
+	}
 	sqlite3_exec(db, "COMMIT;", NULL, NULL, NULL);
-	sqlite3_finalize(stmt_insert_node);
-	sqlite3_finalize(stmt_insert_way);
-	sqlite3_finalize(stmt_insert_relation);
-	sqlite3_finalize(stmt_insert_changeset);
-	sqlite3_finalize(stmt_insert_changeset_tag);
+	sqlite3_finalize(sql.node);
+	sqlite3_finalize(sql.way);
+	sqlite3_finalize(sql.relation);
+	sqlite3_finalize(sql.changeset);
+	sqlite3_finalize(sql.changeset_tag);
+	sqlite3_finalize(sql.node_way);
+	sqlite3_finalize(sql.node_tag);
+	sqlite3_finalize(sql.way_tag);
+	sqlite3_finalize(sql.relation_tag);
+	sqlite3_finalize(sql.keys.find);
+	sqlite3_finalize(sql.keys.add);
+	sqlite3_finalize(sql.vals.find);
+	sqlite3_finalize(sql.vals.add);
+	sqlite3_finalize(sql.user);
+	intern_free(&sql.keys.cache);
+	intern_free(&sql.vals.cache);
+	intern_free(&sql.users);
 	sqlite3_close(db);
-	return 0;
+	if (sql.nodes)
+		nodestore_close(sql.nodes);
+	free(sql.blob);
+	batch_free(&batch);
+	return ok ? 0 : 1;
 }
 
-void sql_insert_elem(const struct OSM_Element *elem, char *action)
+/* Bind without copying. The parser keeps `s` alive until the statement has been stepped. */
+static void bind_slice(sqlite3_stmt *stmt, const int i, const struct LH_Slice s)
+{
+	sqlite3_bind_text(stmt, i, s.len > 0 ? s.p : "", s.len, SQLITE_STATIC); // Missing is '', not NULL
+}
+
+/* Store `uid`'s name, unless it's the one already stored. Most edits are by a user seen before. */
+static void sql_user(struct Sql *sql, const long uid, const struct LH_Slice name)
+{
+	if (name.len == 0)
+		return;
+	const int64_t hash = intern_hash(name.p, name.len);
+	int64_t cached;
+	if (intern_get(&sql->users, (const char *)&uid, sizeof(uid), &cached) && cached == hash)
+		return;
+	// clang-format off
+	sqlite3_bind_int64(sql->user, 1, uid);
+	bind_slice(sql->user,         2, name);
+	// clang-format on
+	const int r = sqlite3_step(sql->user);
+	assert(r == SQLITE_DONE);
+	sqlite3_reset(sql->user);
+	intern_put(&sql->users, (const char *)&uid, sizeof(uid), hash);
+}
+
+static void sql_insert_elem(struct Sql *sql, sqlite3_stmt *stmt, const struct LH_Element *elem,
+			    const enum LH_Action action)
 {
-	sqlite3_stmt *stmt;
-	if (elem->type == NODE)
-		stmt = stmt_insert_node;
-	else if (elem->type == WAY)
-		stmt = stmt_insert_way;
-	else
-		stmt = stmt_insert_relation;
 	// clang-format off
 	sqlite3_bind_int64(stmt, 1, elem->id);
 	sqlite3_bind_int64(stmt, 2, elem->version);
 	sqlite3_bind_int64(stmt, 3, elem->changeset);
-	sqlite3_bind_text(stmt,  4, action, -1, NULL);
+	sqlite3_bind_int64(stmt, 4, elem->timestamp);
+	sqlite3_bind_int64(stmt, 5, elem->uid);
+	sqlite3_bind_int(stmt,   6, action);
 	// clang-format on
 
 	const int r = sqlite3_step(stmt);
 	assert(r == SQLITE_DONE);
+	sql_user(sql, elem->uid, elem->user);
 
 	sqlite3_reset(stmt);
 	sqlite3_clear_bindings(stmt);
 }
 
-void sql_insert_changeset(struct OSM_Changeset *cs)
+static void sql_insert_node(void *ctx, const struct LH_Element *node, const enum LH_Action action)
+{
+	struct Sql *sql = ctx;
+	sql_insert_elem(sql, sql->node, node, action);
+	// A deleted node keeps its last location, where the delete happened.
+	if (sql->nodes && node->located && nodestore_put(sql->nodes, node->id, node->lat, node->lon) != 0)
+		sql->nodes_failed = true;
+}
+
+/* Room for `n` bytes of blob, NULL if there's no memory for it. */
+static uint8_t *blob_reserve(struct Sql *sql, const size_t n)
+{
+	if (sql->blob_cap < n || !sql->blob) {
+		free(sql->blob);
+		sql->blob_cap = n < 4096 ? 4096 : n * 2;
+		sql->blob = malloc(sql->blob_cap);
+		if (!sql->blob) {
+			sql->blob_cap = 0;
+			sql->out_of_memory = true;
+		}
+	}
+	return sql->blob;
+}
+
+static void sql_insert_way(void *ctx, const struct LH_Element *way, const enum LH_Action action)
+{
+	struct Sql *sql = ctx;
+	uint8_t *blob = blob_reserve(sql, REFS_BOUND(way->n_refs));
+	if (!blob)
+		return;
+	sqlite3_bind_blob(sql->way, 7, blob, refs_encode(blob, way->refs, way->n_refs), SQLITE_STATIC);
+	sql_insert_elem(sql, sql->way, way, action);
+
+	if (!sql->node_way)
+		return;
+	for (size_t i = 0; i < way->n_refs; i++) {
+		sqlite3_bind_int64(sql->node_way, 1, way->refs[i]);
+		sqlite3_bind_int64(sql->node_way, 2, way->id);
+		const int r = sqlite3_step(sql->node_way);
+		assert(r == SQLITE_DONE);
+		sqlite3_reset(sql->node_way);
+	}
+}
+
+static void sql_insert_relation(void *ctx, const struct LH_Element *relation, const enum LH_Action action)
+{
+	struct Sql *sql = ctx;
+	uint8_t *blob = blob_reserve(sql, members_bound(relation->members, relation->n_members));
+	if (!blob)
+		return;
+	const size_t len = members_encode(blob, relation->members, relation->n_members);
+	sqlite3_bind_blob(sql->relation, 7, blob, len, SQLITE_STATIC);
+	sql_insert_elem(sql, sql->relation, relation, action);
+}
+
+/* A timestamp, as epoch seconds with -t. One that doesn't parse is stored as the text it was. */
+static void bind_time(const struct Sql *sql, sqlite3_stmt *stmt, const int i, const struct LH_Slice s)
 {
-	sqlite3_stmt *stmt = stmt_insert_changeset;
+	int64_t t;
+	if (sql->epoch_times && parse_timestamp(s.p, s.len, &t))
+		sqlite3_bind_int64(stmt, i, t);
+	else
+		bind_slice(stmt, i, s);
+}
+
+static void sql_insert_changeset(void *ctx, const struct LH_Changeset *cs)
+{
+	struct Sql *sql = ctx;
+	sqlite3_stmt *stmt = sql->changeset;
 	// clang-format off
 	sqlite3_bind_int64(stmt,  1,  cs->id);
-	sqlite3_bind_text(stmt,   2,  cs->created_at, -1, NULL);
+	bind_time(sql, stmt,      2,  cs->created_at);
 	if (!cs->open)
-		sqlite3_bind_text(stmt, 3, cs->closed_at, -1, NULL);
+		bind_time(sql, stmt, 3, cs->closed_at);
 	else
 		sqlite3_bind_null(stmt, 3);
 	sqlite3_bind_int(stmt,    4,  cs->open);
-	sqlite3_bind_text(stmt,   5,  cs->user, -1, NULL);
-	sqlite3_bind_int64(stmt,  6,  cs->uid);
-	sqlite3_bind_double(stmt, 7,  cs->min_lat);
-	sqlite3_bind_double(stmt, 8,  cs->max_lat);
-	sqlite3_bind_double(stmt, 9,  cs->min_lon);
-	sqlite3_bind_double(stmt, 10, cs->max_lon);
-	sqlite3_bind_int64(stmt,  11, cs->comments);
+	sqlite3_bind_int64(stmt,  5,  cs->uid);
+	sqlite3_bind_double(stmt, 6,  cs->min_lat / (double)COORD_SCALE); // The double nearest the text, as strtod gives
+	sqlite3_bind_double(stmt, 7,  cs->max_lat / (double)COORD_SCALE);
+	sqlite3_bind_double(stmt, 8,  cs->min_lon / (double)COORD_SCALE);
+	sqlite3_bind_double(stmt, 9,  cs->max_lon / (double)COORD_SCALE);
+	sqlite3_bind_int64(stmt,  10, cs->comments);
 	// clang-format on
 	const int r = sqlite3_step(stmt);
 	assert(r == SQLITE_DONE);
+	sql_user(sql, cs->uid, cs->user);
 
 	sqlite3_reset(stmt);
 	sqlite3_clear_bindings(stmt);
 }
 
-void sql_insert_changeset_tag(long changeset, char *k, char *v)
+static void sql_insert_changeset_tag(void *ctx, const long changeset, const struct LH_Slice k, const struct LH_Slice v)
 {
-	sqlite3_stmt *stmt = stmt_insert_changeset_tag;
+	sqlite3_stmt *stmt = ((struct Sql *)ctx)->changeset_tag;
 	// clang-format off
 	sqlite3_bind_int64(stmt, 1, changeset);
-	sqlite3_bind_text(stmt,  2, k, -1, NULL);
-	sqlite3_bind_text(stmt,  3, v, -1, NULL);
+	bind_slice(stmt,         2, k);
+	bind_slice(stmt,         3, v);
 	// clang-format on
 	const int r = sqlite3_step(stmt);
 	assert(r == SQLITE_DONE);
@@ -300,47 +447,44 @@ void sql_insert_changeset_tag(long changeset, char *k, char *v)
 	sqlite3_clear_bindings(stmt);
 }
 
-void elem_attr_add(struct OSM_Element *elem, const char *attr_name, const char *attr_val)
+/* The id of `s` in dictionary `d`, added if it's new. The cache saves the lookup for repeats, which
+ * most tags are. */
+static int64_t dict_id(struct Dict *d, const struct LH_Slice s)
 {
-	if (streq(attr_name, "id"))
-		elem->id = strtol(attr_val, NULL, 10);
-	else if (streq(attr_name, "version"))
-		elem->version = strtol(attr_val, NULL, 10);
-	else if (streq(attr_name, "changeset"))
-		elem->changeset = strtol(attr_val, NULL, 10);
+	int64_t id;
+	const char *str = s.len > 0 ? s.p : "";
+	if (intern_get(&d->cache, str, s.len, &id))
+		return id;
+
+	bind_slice(d->find, 1, s);
+	if (sqlite3_step(d->find) == SQLITE_ROW) {
+		id = sqlite3_column_int64(d->find, 0);
+	} else {
+		bind_slice(d->add, 1, s);
+		const int r = sqlite3_step(d->add);
+		assert(r == SQLITE_DONE);
+		id = sqlite3_last_insert_rowid(sqlite3_db_handle(d->add));
+		sqlite3_reset(d->add);
+	}
+	sqlite3_reset(d->find);
+	intern_put(&d->cache, str, s.len, id);
+	return id;
 }
 
-void changeset_attr_add(struct OSM_Changeset *cs, const char *attr_name, const char *attr_val)
+static void sql_insert_tag(void *ctx, const enum LH_Element_Type type, const struct LH_Element *elem,
+			   const struct LH_Slice k, const struct LH_Slice v)
 {
-	if (streq(attr_name, "id"))
-		cs->id = strtol(attr_val, NULL, 10);
-	else if (streq(attr_name, "uid"))
-		cs->uid = strtol(attr_val, NULL, 10);
-	else if (streq(attr_name, "comments_count"))
-		cs->comments = strtol(attr_val, NULL, 10);
-	else if (streq(attr_name, "min_lat"))
-		cs->min_lat = strtod(attr_val, NULL);
-	else if (streq(attr_name, "max_lat"))
-		cs->max_lat = strtod(attr_val, NULL);
-	else if (streq(attr_name, "min_lon"))
-		cs->min_lon = strtod(attr_val, NULL);
-	else if (streq(attr_name, "max_lon"))
-		cs->max_lon = strtod(attr_val, NULL);
-	else if (streq(attr_name, "created_at"))
-		strcpy(cs->created_at, attr_val);
-	else if (streq(attr_name, "closed_at"))
-		strcpy(cs->closed_at, attr_val);
-	else if (streq(attr_name, "user"))
-		strcpy(cs->user, attr_val);
-
-	if (streq(attr_name, "open")) {
-		if (streq(attr_val, "true")) {
-			cs->open = true;
-			cs->closed_at[0] = '\0';
-		} else {
-			cs->open = false;
-		}
-	}
+	struct Sql *sql = ctx;
+	sqlite3_stmt *stmt = type == LH_NODE ? sql->node_tag : type == LH_WAY ? sql->way_tag : sql->relation_tag;
+	// clang-format off
+	sqlite3_bind_int64(stmt, 1, elem->id);
+	sqlite3_bind_int64(stmt, 2, elem->version);
+	sqlite3_bind_int64(stmt, 3, dict_id(&sql->keys, k));
+	sqlite3_bind_int64(stmt, 4, dict_id(&sql->vals, v));
+	// clang-format on
+	const int r = sqlite3_step(stmt);
+	assert(r == SQLITE_DONE);
+	sqlite3_reset(stmt);
 }
 
 void parse_size(const size_t size, char *buf, const int buf_cap)
@@ -355,9 +499,30 @@ void parse_size(const size_t size, char *buf, const int buf_cap)
 		snprintf(buf, buf_cap, "%.1fGB", size / (float)GB_BYTES);
 }
 
-inline bool is_osm_element(const char *str)
+/* Inverse of `parse_size`: "512K", "64M", "1G" or plain bytes. Returns 0 on success. */
+int parse_bytes(const char *str, size_t *size)
 {
-	return streq(str, "node") || streq(str, "way") || streq(str, "relation");
+	char *end;
+	const unsigned long long n = strtoull(str, &end, 10);
+	if (end == str)
+		return -1;
+	switch (*end) {
+	case '\0':
+		*size = n;
+		return 0;
+	case 'K':
+		*size = n * KB_BYTES;
+		break;
+	case 'M':
+		*size = n * MB_BYTES;
+		break;
+	case 'G':
+		*size = n * GB_BYTES;
+		break;
+	default:
+		return -1;
+	}
+	return end[1] == '\0' || streq(end + 1, "B") ? 0 : -1;
 }
 
 inline bool streq(const char *s1, const char *s2)
@@ -0,0 +1,110 @@
+#ifndef NAMES_H
+#define NAMES_H
+
+#include <stdlib.h>
+#include <string.h>
+
+/* The tag and attribute names the parser acts on. */
+enum Name
+{
+	NAME_UNKNOWN,
+	// Tags
+	NAME_OSM,
+	NAME_OSM_CHANGE,
+	NAME_CREATE,
+	NAME_MODIFY,
+	NAME_DELETE,
+	NAME_NODE,
+	NAME_WAY,
+	NAME_RELATION,
+	NAME_CHANGESET, // Also an attribute of elements
+	NAME_TAG,
+	NAME_ND,
+	NAME_MEMBER,
+	// Attributes
+	NAME_ID,
+	NAME_VERSION,
+	NAME_TIMESTAMP,
+	NAME_UID,
+	NAME_USER,
+	NAME_OPEN,
+	NAME_CREATED_AT,
+	NAME_CLOSED_AT,
+	NAME_COMMENTS_COUNT,
+	NAME_LAT,
+	NAME_LON,
+	NAME_MIN_LAT,
+	NAME_MAX_LAT,
+	NAME_MIN_LON,
+	NAME_MAX_LON,
+	NAME_K,
+	NAME_V,
+	NAME_REF,
+	NAME_TYPE,
+	NAME_ROLE
+};
+
+/* Look a name up with a switch on its length and a byte or two, then one fixed-size compare. */
+static inline enum Name name_id(const char *s, const size_t len)
+{
+#define NAME_IS(str, id) (memcmp(s, str, sizeof(str) - 1) == 0 ? id : NAME_UNKNOWN)
+	switch (len) {
+	case 1:
+		return *s == 'k' ? NAME_K : *s == 'v' ? NAME_V : NAME_UNKNOWN;
+	case 2:
+		return *s == 'n' ? NAME_IS("nd", NAME_ND) : NAME_IS("id", NAME_ID);
+	case 3:
+		if (*s == 'o')
+			return NAME_IS("osm", NAME_OSM);
+		if (*s == 'w')
+			return NAME_IS("way", NAME_WAY);
+		if (*s == 'u')
+			return NAME_IS("uid", NAME_UID);
+		if (*s == 'l')
+			return s[1] == 'a' ? NAME_IS("lat", NAME_LAT) : NAME_IS("lon", NAME_LON);
+		if (*s == 'r')
+			return NAME_IS("ref", NAME_REF);
+		return NAME_IS("tag", NAME_TAG);
+	case 4:
+		if (*s == 'n')
+			return NAME_IS("node", NAME_NODE);
+		if (*s == 'u')
+			return NAME_IS("user", NAME_USER);
+		if (*s == 't')
+			return NAME_IS("type", NAME_TYPE);
+		if (*s == 'r')
+			return NAME_IS("role", NAME_ROLE);
+		return NAME_IS("open", NAME_OPEN);
+	case 6:
+		if (*s == 'c')
+			return NAME_IS("create", NAME_CREATE);
+		if (*s == 'm')
+			return s[1] == 'o' ? NAME_IS("modify", NAME_MODIFY) : NAME_IS("member", NAME_MEMBER);
+		return NAME_IS("delete", NAME_DELETE);
+	case 7:
+		if (*s == 'v')
+			return NAME_IS("version", NAME_VERSION);
+		if (s[5] == 'a')
+			return s[1] == 'i' ? NAME_IS("min_lat", NAME_MIN_LAT) : NAME_IS("max_lat", NAME_MAX_LAT);
+		return s[1] == 'i' ? NAME_IS("min_lon", NAME_MIN_LON) : NAME_IS("max_lon", NAME_MAX_LON);
+	case 8:
+		return NAME_IS("relation", NAME_RELATION);
+	case 9:
+		if (s[1] == 'h')
+			return NAME_IS("changeset", NAME_CHANGESET);
+		if (s[1] == 's')
+			return NAME_IS("osmChange", NAME_OSM_CHANGE);
+		if (s[1] == 'i')
+			return NAME_IS("timestamp", NAME_TIMESTAMP);
+		return NAME_IS("closed_at", NAME_CLOSED_AT);
+	case 10:
+		return NAME_IS("created_at", NAME_CREATED_AT);
+	case 14:
+		return NAME_IS("comments_count", NAME_COMMENTS_COUNT);
+	default:
+		return NAME_UNKNOWN;
+	}
+#undef NAME_IS
+}
+
+#endif
@@ -0,0 +1,89 @@
+#define _GNU_SOURCE // mremap
+#include "nodestore.h"
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define NODESTORE_BIAS 0x80000000u
+
+/* Open or create the store at `path`. Returns 0 on success. */
+int nodestore_open(struct Node_Store *ns, const char *path)
+{
+	memset(ns, 0, sizeof(*ns));
+	ns->fd = open(path, O_RDWR | O_CREAT, 0644);
+	if (ns->fd < 0)
+		return -1;
+
+	struct stat st;
+	if (fstat(ns->fd, &st) < 0)
+		goto fail;
+	ns->n = st.st_size / sizeof(*ns->slots);
+	if (ns->n < NODESTORE_MIN_SLOTS) {
+		ns->n = NODESTORE_MIN_SLOTS;
+		if (ftruncate(ns->fd, ns->n * sizeof(*ns->slots)) < 0)
+			goto fail;
+	}
+	void *p = mmap(NULL, ns->n * sizeof(*ns->slots), PROT_READ | PROT_WRITE, MAP_SHARED, ns->fd, 0);
+	if (p == MAP_FAILED)
+		goto fail;
+	// Diffs touch ids all over the range, reading ahead around each one is wasted.
+	madvise(p, ns->n * sizeof(*ns->slots), MADV_RANDOM);
+	ns->slots = p;
+	return 0;
+
+fail:
+	close(ns->fd);
+	ns->fd = -1;
+	return -1;
+}
+
+/* Make room for slot `id`, doubling so that growing takes log(ids) remaps. */
+static int nodestore_grow(struct Node_Store *ns, const size_t id)
+{
+	size_t n = ns->n;
+	while (n <= id)
+		n *= 2;
+	if (ftruncate(ns->fd, n * sizeof(*ns->slots)) < 0)
+		return -1;
+	void *p = mremap(ns->slots, ns->n * sizeof(*ns->slots), n * sizeof(*ns->slots), MREMAP_MAYMOVE);
+	if (p == MAP_FAILED)
+		return -1;
+	madvise(p, n * sizeof(*ns->slots), MADV_RANDOM);
+	ns->slots = p;
+	ns->n = n;
+	return 0;
+}
+
+/* Store the location of node `id`, replacing any earlier one. Negative ids (not uploaded yet) are
+ * skipped. Returns 0 on success. */
+int nodestore_put(struct Node_Store *ns, const long id, const int32_t lat, const int32_t lon)
+{
+	if (id < 0)
+		return 0;
+	if ((size_t)id >= ns->n && nodestore_grow(ns, id) != 0)
+		return -1;
+	ns->slots[id] = (uint64_t)((uint32_t)lat + NODESTORE_BIAS) << 32 | ((uint32_t)lon + NODESTORE_BIAS);
+	return 0;
+}
+
+/* The location of node `id`. Returns false if none has been stored. */
+bool nodestore_get(const struct Node_Store *ns, const long id, int32_t *lat, int32_t *lon)
+{
+	if (id < 0 || (size_t)id >= ns->n || ns->slots[id] == 0)
+		return false;
+	*lat = (int32_t)((uint32_t)(ns->slots[id] >> 32) - NODESTORE_BIAS);
+	*lon = (int32_t)((uint32_t)ns->slots[id] - NODESTORE_BIAS);
+	return true;
+}
+
+void nodestore_close(struct Node_Store *ns)
+{
+	if (ns->slots)
+		munmap(ns->slots, ns->n * sizeof(*ns->slots));
+	if (ns->fd >= 0)
+		close(ns->fd);
+	ns->slots = NULL;
+	ns->fd = -1;
+}
@@ -0,0 +1,29 @@
+#ifndef NODESTORE_H
+#define NODESTORE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/* Slots the store file starts out with and grows by at least. */
+#define NODESTORE_MIN_SLOTS (1 << 24)
+
+/* Node locations in a flat file, one 8-byte slot per node id. Slot `id` holds lat and lon, each
+ * offset by 2^31 so that an all-zero slot means no location. The file grows with ftruncate, so ids
+ * never written are holes and take no disk. */
+struct Node_Store
+{
+	int fd;
+	uint64_t *slots; // Mapped shared, writes go straight to the file.
+	size_t n;	 // Slots mapped, the file size over 8.
+};
+
+int nodestore_open(struct Node_Store *ns, const char *path);
+
+int nodestore_put(struct Node_Store *ns, long id, int32_t lat, int32_t lon);
+
+bool nodestore_get(const struct Node_Store *ns, long id, int32_t *lat, int32_t *lon);
+
+void nodestore_close(struct Node_Store *ns);
+
+#endif
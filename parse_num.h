@@ -0,0 +1,125 @@
+#ifndef PARSE_NUM_H
+#define PARSE_NUM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* 8 bytes from `p`, unless that would cross into the next page, which might not be mapped. Bytes past
+ * the end of the string are read but masked off by the caller. */
+__attribute__((no_sanitize_address)) static inline bool num_load8(const char *p, uint64_t *v)
+{
+	if (((uintptr_t)p & 4095) > 4096 - 8)
+		return false;
+	memcpy(v, p, 8);
+	return true;
+}
+
+/* The value of the first `len` (1-8) bytes of `v` as decimal digits, first digit in the lowest byte.
+ * UINT64_MAX if any of them isn't a digit. */
+static inline uint64_t num_swar8(uint64_t v, const size_t len)
+{
+	// Move the digits to the top and fill in below with '0's, which read as leading zeros.
+	const unsigned pad = 8 * (8 - len);
+	v = (v << pad) | (0x3030303030303030 & ((1ULL << pad) - 1));
+	if (((v & 0xF0F0F0F0F0F0F0F0) | ((v + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0) >> 4) != 0x3333333333333333)
+		return UINT64_MAX;
+	v = (v & 0x0F0F0F0F0F0F0F0F) * 2561 >> 8;		// Pairs of digits
+	v = (v & 0x00FF00FF00FF00FF) * 6553601 >> 16;		// Fours
+	return (uint32_t)((v & 0x0000FFFF0000FFFF) * 42949672960001 >> 32); // Eight
+}
+
+/* Parse `len` decimal digits, nothing else. False if there are none, anything else is in there or it
+ * doesn't fit in 64 bits. Up to 16 digits take one or two 8-byte steps. */
+static inline bool parse_uint(const char *p, const size_t len, uint64_t *out)
+{
+	uint64_t a, b;
+	if (len == 0) {
+		return false;
+	} else if (len <= 8 && num_load8(p, &a)) {
+		*out = num_swar8(a, len);
+		return *out != UINT64_MAX;
+	} else if (len > 8 && len <= 16 && num_load8(p, &a) && num_load8(p + len - 8, &b)) {
+		const uint64_t hi = num_swar8(a, len - 8), lo = num_swar8(b, 8);
+		*out = hi * 100000000 + lo;
+		return hi != UINT64_MAX && lo != UINT64_MAX;
+	}
+
+	// Longer than 16 digits, or too close to the end of a page
+	uint64_t n = 0;
+	for (size_t i = 0; i < len; i++) {
+		const unsigned d = (unsigned char)p[i] - '0';
+		if (d > 9 || __builtin_mul_overflow(n, 10, &n) || __builtin_add_overflow(n, d, &n))
+			return false;
+	}
+	*out = n;
+	return true;
+}
+
+/* `parse_uint` with an optional leading '-'. */
+static inline bool parse_int(const char *p, const size_t len, int64_t *out)
+{
+	const bool neg = len > 0 && *p == '-';
+	uint64_t n;
+	if (!parse_uint(p + neg, len - neg, &n) || n > (uint64_t)INT64_MAX + neg)
+		return false;
+	*out = neg ? (int64_t)(0 - n) : (int64_t)n;
+	return true;
+}
+
+/* Coordinates are stored as whole numbers of this many parts of a degree, like OSM itself does. */
+#define COORD_SCALE 10000000
+
+/* A coordinate in degrees with up to 7 decimals, e.g. "-0.1275" or "51.5073509", as 1e-7 degrees.
+ * False for any other form, or beyond +-214 degrees. Exact, unlike going through a double. */
+static inline bool parse_coord(const char *p, size_t len, int32_t *out)
+{
+	static const uint32_t frac_scale[8] = {10000000, 1000000, 100000, 10000, 1000, 100, 10, 1};
+	const bool neg = len > 0 && *p == '-';
+	p += neg;
+	len -= neg;
+	size_t int_len = 0;
+	while (int_len < len && int_len < 4 && p[int_len] != '.')
+		int_len++;
+	const bool dot = int_len < len;
+	const size_t frac_len = dot ? len - int_len - 1 : 0;
+
+	uint64_t deg, frac = 0;
+	if (int_len > 3 || frac_len > 7 || !parse_uint(p, int_len, &deg) ||
+	    (dot && !parse_uint(p + int_len + 1, frac_len, &frac)))
+		return false;
+	const uint64_t n = deg * COORD_SCALE + frac * frac_scale[frac_len];
+	if (n > INT32_MAX)
+		return false;
+	*out = neg ? -(int32_t)n : (int32_t)n;
+	return true;
+}
+
+/* Days from 1970-01-01 to y-m-d in the proleptic Gregorian calendar, counting March-based years so
+ * the leap day falls last (H. Hinnant's days_from_civil). */
+static inline int64_t days_from_civil(int64_t y, const unsigned m, const unsigned d)
+{
+	y -= m <= 2;
+	const int64_t era = (y >= 0 ? y : y - 399) / 400;
+	const unsigned yoe = (unsigned)(y - era * 400);
+	const unsigned doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+	const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+	return era * 146097 + (int64_t)doe - 719468;
+}
+
+/* "YYYY-MM-DDTHH:MM:SSZ", the only form OSM writes, as seconds since 1970. False for anything else. */
+static inline bool parse_timestamp(const char *p, const size_t len, int64_t *out)
+{
+	uint64_t y, mo, d, h, mi, s;
+	if (len != 20 || p[4] != '-' || p[7] != '-' || p[10] != 'T' || p[13] != ':' || p[16] != ':' || p[19] != 'Z' ||
+	    !parse_uint(p, 4, &y) || !parse_uint(p + 5, 2, &mo) || !parse_uint(p + 8, 2, &d) ||
+	    !parse_uint(p + 11, 2, &h) || !parse_uint(p + 14, 2, &mi) || !parse_uint(p + 17, 2, &s))
+		return false;
+	if (mo < 1 || mo > 12 || d < 1 || d > 31 || h > 23 || mi > 59 || s > 60)
+		return false;
+	*out = days_from_civil(y, mo, d) * 86400 + h * 3600 + mi * 60 + s;
+	return true;
+}
+
+#endif
@@ -0,0 +1,737 @@
+#include "parser.h"
+#include "entity.h"
+#include "names.h"
+#include "parse_num.h"
+#include "scan.h"
+#include "structural.h"
+#include <string.h>
+
+void parser_init(struct Parser *p)
+{
+	memset(p, 0, sizeof(*p));
+	p->state = IDLE;
+	p->start_tag = true;
+}
+
+/* Start mid-document at `split`, as if its enclosing start-tags had already been seen. */
+void parser_init_split(struct Parser *p, const struct LH_Split *split)
+{
+	parser_init(p);
+	for (size_t i = 0; i < split->depth; i++)
+		tstack_push(&p->tags, name_id(split->context[i], strlen(split->context[i])));
+	p->at_split = true;
+}
+
+/* Work out what the innermost open tag is, from the stack. */
+static void tag_classify(struct Parser *p)
+{
+	struct LH_Element *elem = &p->elem;
+	switch (tstack_top(&p->tags)) {
+	case NAME_NODE:
+		elem->type = LH_NODE;
+		break;
+	case NAME_WAY:
+		elem->type = LH_WAY;
+		break;
+	case NAME_RELATION:
+		elem->type = LH_RELATION;
+		break;
+	case NAME_CHANGESET:
+		elem->type = LH_CHANGESET;
+		break;
+	case NAME_TAG:
+		switch (tstack_n(&p->tags, 1)) {
+		case NAME_CHANGESET:
+			elem->type = LH_CHANGESET_TAG;
+			break;
+		case NAME_NODE:
+		case NAME_WAY:
+		case NAME_RELATION:
+			elem->type = LH_ELEMENT_TAG;
+			break;
+		default:
+			elem->type = LH_NOT;
+			break;
+		}
+		break;
+	case NAME_ND:
+		elem->type = tstack_n(&p->tags, 1) == NAME_WAY ? LH_WAY_ND : LH_NOT;
+		break;
+	case NAME_MEMBER:
+		elem->type = tstack_n(&p->tags, 1) == NAME_RELATION ? LH_RELATION_MEMBER : LH_NOT;
+		break;
+	default:
+		elem->type = LH_NOT;
+		break;
+	}
+}
+
+/* `a` with room for at least `n` items of `size` bytes, or NULL if it couldn't grow; `a` is still
+ * there then, as it was. */
+static void *array_reserve(void *a, size_t *cap, const size_t n, const size_t size)
+{
+	if (*cap >= n)
+		return a;
+	const size_t grown = n < 32 ? 64 : n * 2;
+	void *b = realloc(a, grown * size);
+	if (b)
+		*cap = grown;
+	return b;
+}
+
+/* Start-tag '<tag'. */
+static void tag_open(struct Parser *p, const enum Name tag)
+{
+	tstack_push(&p->tags, tag);
+	tag_classify(p);
+	switch (p->elem.type) {
+	case LH_CHANGESET:
+		memset(&p->changeset, 0, sizeof(p->changeset)); // Attributes are optional, don't inherit the last one's
+		break;
+	case LH_NODE:
+	case LH_WAY:
+	case LH_RELATION:
+		p->elem.timestamp = 0;
+		p->elem.uid = 0;
+		p->elem.user = (struct LH_Slice){0}; // Redacted or anonymous edits have none
+		p->elem.located = false;
+		p->elem.lat = p->elem.lon = 0;
+		// Set only just before the way or relation callback, the arrays move as they grow
+		p->elem.refs = NULL;
+		p->elem.n_refs = 0;
+		p->elem.members = NULL;
+		p->elem.n_members = 0;
+		p->refs_n = 0;
+		p->members_n = 0;
+		p->roles_len = 0;
+		break;
+	case LH_CHANGESET_TAG:
+	case LH_ELEMENT_TAG:
+		p->tag_k = p->tag_v = (struct LH_Slice){0}; // A missing k or v is empty, not the last tag's
+		break;
+	case LH_RELATION_MEMBER: {
+		struct LH_Member *members = array_reserve(p->members, &p->members_cap, p->members_n + 1, sizeof(*members));
+		if (!members) {
+			p->failed = true;
+			break;
+		}
+		p->members = members;
+		p->members[p->members_n++] = (struct LH_Member){.type = LH_NOT};
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+/* The action of an element whose parent is `parent`. */
+static inline enum LH_Action tag_action(const enum Name parent)
+{
+	switch (parent) {
+	case NAME_CREATE:
+		return LH_ACTION_CREATE;
+	case NAME_MODIFY:
+		return LH_ACTION_MODIFY;
+	case NAME_DELETE:
+		return LH_ACTION_DELETE;
+	default:
+		return LH_ACTION_NONE;
+	}
+}
+
+/* The current element is complete, hand it over and leave it. */
+static void tag_close(struct Parser *p)
+{
+	const struct LH_Callbacks *cb = &p->cb;
+	struct LH_Element *elem = &p->elem;
+	const enum LH_Action action = tag_action(tstack_n(&p->tags, 1));
+	switch (p->failed ? LH_NOT : elem->type) { // Out of memory, the element may be missing parts
+	case LH_NODE:
+		if (cb->node)
+			cb->node(p->ctx, elem, action);
+		break;
+	case LH_WAY:
+		elem->refs = p->refs;
+		elem->n_refs = p->refs_n;
+		if (cb->way)
+			cb->way(p->ctx, elem, action);
+		break;
+	case LH_RELATION: {
+		const char *role = p->roles;
+		for (size_t i = 0; i < p->members_n; i++) {
+			p->members[i].role.p = role;
+			role += p->members[i].role.len;
+		}
+		elem->members = p->members;
+		elem->n_members = p->members_n;
+		if (cb->relation)
+			cb->relation(p->ctx, elem, action);
+		break;
+	}
+	case LH_CHANGESET:
+		if (cb->changeset)
+			cb->changeset(p->ctx, &p->changeset);
+		break;
+	case LH_CHANGESET_TAG:
+		if (cb->changeset_tag)
+			cb->changeset_tag(p->ctx, p->changeset.id, p->tag_k, p->tag_v);
+		break;
+	case LH_ELEMENT_TAG: {
+		const enum Name parent = tstack_n(&p->tags, 1);
+		const enum LH_Element_Type type = parent == NAME_NODE ? LH_NODE : parent == NAME_WAY ? LH_WAY : LH_RELATION;
+		if (cb->tag)
+			cb->tag(p->ctx, type, elem, p->tag_k, p->tag_v);
+		break;
+	}
+	default:
+		break;
+	}
+
+	tstack_pop(&p->tags);
+}
+
+/* A whole-number attribute. Anything that isn't one reads as 0. */
+static inline long attr_long(const struct LH_Slice val)
+{
+	int64_t n;
+	return parse_int(val.p, val.len, &n) ? n : 0;
+}
+
+/* A coordinate attribute in 1e-7 degrees. Anything parse_coord doesn't take, e.g. an exponent or more
+ * decimals, goes through strtod, which the closing quote (or a NUL) after `val` stops. */
+static inline int32_t attr_coord(const struct LH_Slice val)
+{
+	int32_t n;
+	if (parse_coord(val.p, val.len, &n))
+		return n;
+	const double d = strtod(val.p, NULL) * COORD_SCALE;
+	return d > -INT32_MAX && d < INT32_MAX ? (int32_t)(d < 0 ? d - 0.5 : d + 0.5) : 0;
+}
+
+/* Text attribute `val` with its entities decoded. Only a value with an '&' in it is copied, into
+ * `kept[slot]`; the rest are handed back as they are. */
+static struct LH_Slice attr_text(struct Parser *p, const struct LH_Slice val, const enum Kept slot)
+{
+	const char *end = val.p + val.len;
+	if (scan_find(val.p, end, '&') == end)
+		return val;
+	return (struct LH_Slice){p->kept[slot], entity_decode(p->kept[slot], sizeof(p->kept[slot]), val.p, val.len)};
+}
+
+/* An attribute of the last <member> of the open relation. The role is copied, decoded, into `roles`. */
+static void member_attr_add(struct Parser *p, const struct LH_Slice name, const struct LH_Slice val)
+{
+	struct LH_Member *m = &p->members[p->members_n - 1];
+	switch (name_id(name.p, name.len)) {
+	case NAME_TYPE: {
+		const enum Name t = name_id(val.p, val.len);
+		m->type = t == NAME_NODE ? LH_NODE : t == NAME_WAY ? LH_WAY : t == NAME_RELATION ? LH_RELATION : LH_NOT;
+		break;
+	}
+	case NAME_REF:
+		m->ref = attr_long(val);
+		break;
+	case NAME_ROLE:
+		if (m->role.len > 0 || val.len == 0) // Only one, or the packing is off. An empty one needs no room.
+			break;
+		char *roles = array_reserve(p->roles, &p->roles_cap, p->roles_len + val.len, 1);
+		if (!roles) {
+			p->failed = true;
+			break;
+		}
+		p->roles = roles;
+		if (scan_find(val.p, val.p + val.len, '&') == val.p + val.len) {
+			memcpy(p->roles + p->roles_len, val.p, val.len);
+			m->role.len = val.len;
+		} else {
+			m->role.len = entity_decode(p->roles + p->roles_len, val.len, val.p, val.len); // Never longer
+		}
+		p->roles_len += m->role.len;
+		break;
+	default:
+		break;
+	}
+}
+
+/* An attribute of the current element. `val` has to stay put until the element is stored or the
+ * chunk ends, whichever is first; `name` only for the call. */
+static void attr_add(struct Parser *p, const struct LH_Slice name, const struct LH_Slice val)
+{
+	const enum LH_Element_Type type = p->elem.type;
+	if (p->failed)
+		return;
+	if (type == LH_NODE || type == LH_WAY || type == LH_RELATION) {
+		elem_attr_add(&p->elem, name, val);
+		if (p->elem.user.p == val.p)
+			p->elem.user = attr_text(p, val, KEPT_ELEM_USER);
+	} else if (type == LH_CHANGESET) {
+		changeset_attr_add(&p->changeset, name, val);
+		if (p->changeset.user.p == val.p) // It was the user name, the only free text of a changeset
+			p->changeset.user = attr_text(p, val, KEPT_USER);
+	} else if ((type == LH_CHANGESET_TAG || type == LH_ELEMENT_TAG) && name.len == 1 && *name.p == 'k') {
+		p->tag_k = attr_text(p, val, KEPT_TAG_K);
+	} else if ((type == LH_CHANGESET_TAG || type == LH_ELEMENT_TAG) && name.len == 1 && *name.p == 'v') {
+		p->tag_v = attr_text(p, val, KEPT_TAG_V);
+	} else if (type == LH_WAY_ND && name_id(name.p, name.len) == NAME_REF) {
+		long *refs = array_reserve(p->refs, &p->refs_cap, p->refs_n + 1, sizeof(*refs));
+		if (!refs) {
+			p->failed = true;
+			return;
+		}
+		p->refs = refs;
+		p->refs[p->refs_n++] = attr_long(val);
+	} else if (type == LH_RELATION_MEMBER) {
+		member_attr_add(p, name, val);
+	}
+}
+
+/* The input is about to move on. Copy what an open element still points to out of it. */
+static void keep_slices(struct Parser *p)
+{
+	struct LH_Slice *live[PARSER_KEPT] = {
+		[KEPT_CREATED_AT] = &p->changeset.created_at,
+		[KEPT_CLOSED_AT] = &p->changeset.closed_at,
+		[KEPT_USER] = &p->changeset.user,
+		[KEPT_ELEM_USER] = &p->elem.user,
+		[KEPT_TAG_K] = &p->tag_k,
+		[KEPT_TAG_V] = &p->tag_v,
+	};
+	for (size_t i = 0; i < PARSER_KEPT; i++) {
+		if (live[i]->len == 0 || live[i]->p == p->kept[i])
+			continue;
+		if (live[i]->len > sizeof(p->kept[i]))
+			live[i]->len = sizeof(p->kept[i]);
+		memcpy(p->kept[i], live[i]->p, live[i]->len);
+		live[i]->p = p->kept[i];
+	}
+}
+
+static void feed_indexed(struct Parser *p, const char *buf, size_t len);
+
+/* Parse `len` bytes of `buf` the way `p->mode` says. Chunks can be split anywhere, even mid-tag.
+ * Returns 0, or -1 once it has run out of memory; the rest of the input is dropped then. */
+int parser_feed(struct Parser *p, const char *buf, const size_t len)
+{
+	if (p->failed)
+		return -1;
+	if (p->mode == LH_PARSER_INDEXED) {
+		feed_indexed(p, buf, len);
+		return p->failed ? -1 : 0;
+	}
+
+	// Keep the hot state in locals; writes through `p` would alias `buf`.
+	enum State state = p->state;
+	int sub_cursor = p->sub_cursor;
+	int skip = p->skip;
+	bool start_tag = p->start_tag;
+	size_t attr_name_len = p->attr_name_len;
+	const char *end = buf + len;
+
+	for (size_t i = 0; i < len; i++) {
+		if (skip > 0) {
+			skip--;
+			continue;
+		}
+		const char c = buf[i];
+
+		switch (state) {
+		case IDLE: {
+			// Only whitespace and text until the next <tag> || </tag>, jump straight there.
+			const char *lt = scan_find(buf + i, end, '<');
+			i = lt - buf;
+			if (lt != end)
+				state = TAG;
+			break;
+		}
+		case TAG:
+			switch (c) {
+			case ' ': // '<tag '
+				state = ATTR_NAME;
+				goto found_tag_name;
+			case '>': // <tag>
+				state = IDLE;
+				goto found_tag_name;
+			case '?': // <?
+				state = IDLE;
+				goto exit_tag_name;
+			case '/': // </tag>
+				start_tag = false;
+				break;
+			default:
+				if (sub_cursor < (int)sizeof(p->tag_name))
+					p->tag_name[sub_cursor++] = c;
+				break;
+			}
+			break;
+
+		found_tag_name:
+			if (start_tag) {
+				tag_open(p, name_id(p->tag_name, sub_cursor));
+			} else {
+				// End-tag '</tag>' (we have had some markup in-between)
+				// Have to check what we're leaving in case of <changeset><tag /></changeset>
+				// At </changeset> elem will still be <tag.
+				tag_classify(p);
+				tag_close(p);
+			}
+		exit_tag_name:
+			sub_cursor = 0;
+			start_tag = true;
+			break;
+		case ATTR_NAME:
+			if (c == '=') {
+				// we have the name
+				attr_name_len = sub_cursor;
+
+				sub_cursor = 0;
+				skip = 1; // Skip opening quote
+				state = ATTR_VAL;
+				break;
+			}
+			// Empty-element tags would be supported here but we won't.
+			// i.e. all nodes must have >= 1 attribute.
+			if (sub_cursor < (int)sizeof(p->attr_name))
+				p->attr_name[sub_cursor++] = c;
+			break;
+		case ATTR_VAL: {
+			// Take everything up to the closing quote in one go.
+			const char *quote = scan_find(buf + i, end, '"');
+			const struct LH_Slice name = {p->attr_name, attr_name_len};
+			if (quote != end && sub_cursor == 0) {
+				// The whole value is in this chunk, hand it out where it is
+				attr_add(p, name, (struct LH_Slice){buf + i, quote - (buf + i)});
+				i = quote - buf;
+				state = AFTER_ATTR_VAL;
+				break;
+			}
+			// Split across chunks, collect it. Overlong values are truncated.
+			if (sub_cursor == 0)
+				keep_slices(p); // The last value collected may still be in use
+			size_t n = quote - (buf + i);
+			if (n > sizeof(p->attr_val) - 1 - sub_cursor)
+				n = sizeof(p->attr_val) - 1 - sub_cursor;
+			memcpy(p->attr_val + sub_cursor, buf + i, n);
+			sub_cursor += n;
+			i = quote - buf;
+			if (quote != end) {
+				// val and name acquired now
+				p->attr_val[sub_cursor] = '\0'; // Numbers are parsed up to a non-digit
+				attr_add(p, name, (struct LH_Slice){p->attr_val, sub_cursor});
+
+				sub_cursor = 0;
+				state = AFTER_ATTR_VAL;
+			}
+			break;
+		}
+		case AFTER_ATTR_VAL:
+			if (c == ' ') {
+				state = ATTR_NAME;
+				break;
+			}
+			if (c == '"')
+				break;
+			if (c == '/') // End-tag with no markup in-between
+				tag_close(p);
+			state = IDLE;
+			break;
+		}
+	}
+
+	p->state = state;
+	p->sub_cursor = sub_cursor;
+	p->skip = skip;
+	p->start_tag = start_tag;
+	p->attr_name_len = attr_name_len;
+	keep_slices(p);
+	return p->failed ? -1 : 0;
+}
+
+static inline bool is_space(const char c)
+{
+	return c == ' ' || c == '\n' || c == '\t' || c == '\r';
+}
+
+/* Stage 2: turn the structurals of `w` into tags and attributes. `w` starts outside any tag.
+ * Returns how much of it was used, i.e. up to the '<' of a tag that isn't all there yet. */
+static size_t walk_index(struct Parser *p, const char *w, const size_t wlen, const uint32_t *pos, const size_t n)
+{
+	size_t k = 0;
+	while (k < n) {
+		const uint32_t lt = pos[k++];
+		if (w[lt] != '<') // Stray text between tags, quotes included
+			continue;
+
+		// The '>' that ends it, the first one outside a value. Quotes only pair up from the '<'.
+		const char *name = w + lt + 1;
+		const bool markup = lt + 1 < wlen && (*name == '/' || *name == '?' || *name == '!');
+		size_t gt = k;
+		for (bool quote = false; gt < n; gt++) {
+			const char c = w[pos[gt]];
+			if (c == '"' && !markup)
+				quote = !quote;
+			else if (c == '>' && !quote)
+				break;
+		}
+		if (gt == n)
+			return lt;
+
+		if (markup) {
+			k = gt + 1;
+			if (*name == '/') { // </tag>
+				tag_classify(p);
+				tag_close(p);
+			}
+			continue;
+		}
+
+		// <tag ...> or <tag .../>
+		const char *name_end = name;
+		while (name_end < w + pos[k] && !is_space(*name_end))
+			name_end++;
+		tag_open(p, name_id(name, name_end - name));
+
+		const char *attr = name_end;
+		bool empty = false;
+		for (; k < gt; k++) {
+			const char c = w[pos[k]];
+			if (c == '/')
+				empty = true;
+			if (c == '"') { // A value with no '=' before it
+				while (w[pos[++k]] != '"')
+					;
+				continue;
+			}
+			if (c != '=' || w[pos[k + 1]] != '"')
+				continue;
+			size_t close = k + 2; // The value can hold any structural but a quote
+			while (w[pos[close]] != '"')
+				close++;
+			const char *attr_end = w + pos[k];
+			while (attr < attr_end && is_space(*attr))
+				attr++;
+			while (attr_end > attr && is_space(attr_end[-1]))
+				attr_end--;
+			const char *val = w + pos[k + 1] + 1;
+			attr_add(p, (struct LH_Slice){attr, attr_end - attr}, (struct LH_Slice){val, w + pos[close] - val});
+			attr = w + pos[close] + 1;
+			k = close;
+		}
+		k = gt + 1;
+		if (empty)
+			tag_close(p);
+	}
+	return wlen;
+}
+
+/* Room for the structurals of `n` bytes, at most one each. */
+static bool index_reserve(struct Parser *p, const size_t n)
+{
+	if (p->index_cap >= n)
+		return true;
+	free(p->index);
+	p->index = malloc(n * sizeof(*p->index));
+	p->index_cap = p->index ? n : 0;
+	p->failed |= !p->index;
+	return p->index;
+}
+
+/* Room for `n` bytes of carried tag. */
+static bool carry_reserve(struct Parser *p, const size_t n)
+{
+	if (p->carry_cap >= n)
+		return true;
+	char *carry = realloc(p->carry, n * 2);
+	if (!carry) {
+		p->failed = true;
+		return false;
+	}
+	p->carry = carry;
+	p->carry_cap = n * 2;
+	return true;
+}
+
+/* Index and walk `len` bytes that start outside any tag, a window at a time so the index stays in
+ * cache. Returns how much was used, everything but a tag cut off by the end of `buf`. */
+static size_t feed_windows(struct Parser *p, const char *buf, const size_t len)
+{
+	size_t window = PARSER_WINDOW;
+	size_t s = 0;
+	while (s < len) {
+		const size_t wlen = len - s < window ? len - s : window;
+		if (!index_reserve(p, wlen))
+			return len;
+		const size_t n = structural_index(buf + s, wlen, p->index);
+		const size_t used = walk_index(p, buf + s, wlen, p->index, n);
+		if (used < wlen && s + wlen == len)
+			return s + used;
+		window = used == 0 ? window * 2 : PARSER_WINDOW; // A single tag longer than the window
+		s += used;
+	}
+	return len;
+}
+
+/* The structural-index parser. Produces the same rows as the state machine. */
+static void feed_indexed(struct Parser *p, const char *buf, size_t len)
+{
+	if (p->carry_len > 0) {
+		// Finish the tag cut off at the end of the last chunk first.
+		bool quote = p->carry_quote;
+		size_t i = 0;
+		for (; i < len; i++) {
+			if (buf[i] == '"')
+				quote = !quote;
+			else if (buf[i] == '>' && !quote)
+				break;
+		}
+		const size_t take = i < len ? i + 1 : len;
+		if (!carry_reserve(p, p->carry_len + take))
+			return;
+		memcpy(p->carry + p->carry_len, buf, take);
+		p->carry_len += take;
+		p->carry_quote = quote;
+		if (i == len)
+			return;
+
+		const size_t n = p->carry_len;
+		p->carry_len = 0;
+		if (!index_reserve(p, n))
+			return;
+		walk_index(p, p->carry, n, p->index, structural_index(p->carry, n, p->index));
+		buf += take;
+		len -= take;
+	}
+	const size_t used = feed_windows(p, buf, len);
+	keep_slices(p); // Before `carry` is reused, slices can point into it too
+
+	// Out of input mid-tag. Keep the rest and whether it ends inside a value.
+	const size_t rest = len - used;
+	if (rest == 0)
+		return;
+	if (!carry_reserve(p, rest))
+		return;
+	memcpy(p->carry, buf + used, rest);
+	p->carry_len = rest;
+	p->carry_quote = false;
+	for (size_t i = 0; i < rest; i++)
+		p->carry_quote ^= p->carry[i] == '"';
+}
+
+/* Whether the input fed so far ends cleanly: not inside a tag, and every element closed. At a split
+ * only the entities have to be; the document and .osc blocks around them close in a later one. */
+bool parser_finish(const struct Parser *p)
+{
+	if (p->failed || p->carry_len > 0 || (p->mode == LH_PARSER_SCALAR && (p->state != IDLE || p->skip > 0)))
+		return false;
+	if (!p->at_split)
+		return p->tags.depth == 0;
+	for (size_t i = 0; i < p->tags.depth; i++) {
+		switch (tstack_n(&p->tags, i)) {
+		case NAME_OSM:
+		case NAME_OSM_CHANGE:
+		case NAME_CREATE:
+		case NAME_MODIFY:
+		case NAME_DELETE:
+			break;
+		default:
+			return false;
+		}
+	}
+	return true;
+}
+
+/* Free what the structural-index parser allocated. */
+void parser_free(struct Parser *p)
+{
+	free(p->carry);
+	free(p->index);
+	free(p->refs);
+	free(p->members);
+	free(p->roles);
+	p->carry = NULL;
+	p->index = NULL;
+	p->refs = NULL;
+	p->members = NULL;
+	p->roles = NULL;
+}
+
+void elem_attr_add(struct LH_Element *elem, const struct LH_Slice name, const struct LH_Slice val)
+{
+	switch (name_id(name.p, name.len)) {
+	case NAME_ID:
+		elem->id = attr_long(val);
+		break;
+	case NAME_VERSION:
+		elem->version = attr_long(val);
+		break;
+	case NAME_CHANGESET:
+		elem->changeset = attr_long(val);
+		break;
+	case NAME_TIMESTAMP: {
+		int64_t t;
+		elem->timestamp = parse_timestamp(val.p, val.len, &t) ? t : 0;
+		break;
+	}
+	case NAME_UID:
+		elem->uid = attr_long(val);
+		break;
+	case NAME_USER:
+		elem->user = val;
+		break;
+	case NAME_LAT:
+		elem->lat = attr_coord(val);
+		elem->located = true;
+		break;
+	case NAME_LON:
+		elem->lon = attr_coord(val);
+		elem->located = true;
+		break;
+	default:
+		break;
+	}
+}
+
+void changeset_attr_add(struct LH_Changeset *cs, const struct LH_Slice name, const struct LH_Slice val)
+{
+	switch (name_id(name.p, name.len)) {
+	case NAME_ID:
+		cs->id = attr_long(val);
+		break;
+	case NAME_UID:
+		cs->uid = attr_long(val);
+		break;
+	case NAME_COMMENTS_COUNT:
+		cs->comments = attr_long(val);
+		break;
+	case NAME_MIN_LAT:
+		cs->min_lat = attr_coord(val);
+		break;
+	case NAME_MAX_LAT:
+		cs->max_lat = attr_coord(val);
+		break;
+	case NAME_MIN_LON:
+		cs->min_lon = attr_coord(val);
+		break;
+	case NAME_MAX_LON:
+		cs->max_lon = attr_coord(val);
+		break;
+	case NAME_CREATED_AT:
+		cs->created_at = val;
+		break;
+	case NAME_CLOSED_AT:
+		cs->closed_at = val;
+		break;
+	case NAME_USER:
+		cs->user = val;
+		break;
+	case NAME_OPEN:
+		if (lh_slice_eq(val, "true")) {
+			cs->open = true;
+			cs->closed_at.len = 0;
+		} else {
+			cs->open = false;
+		}
+		break;
+	default:
+		break;
+	}
+}
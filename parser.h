@@ -0,0 +1,96 @@
+#ifndef PARSER_H
+#define PARSER_H
+
+#include "lighthouse.h"
+#include "slice.h"
+#include "split.h"
+#include "tag_stack.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/* Strings an open element can hold on to across chunks, each with its own room in `kept`. */
+enum Kept
+{
+	KEPT_CREATED_AT,
+	KEPT_CLOSED_AT,
+	KEPT_USER,
+	KEPT_ELEM_USER,
+	KEPT_TAG_K,
+	KEPT_TAG_V,
+	PARSER_KEPT
+};
+
+/* The structural-index parser indexes and walks its input this much at a time. */
+#define PARSER_WINDOW (64 * 1024)
+
+enum State
+{
+	TAG,
+	ATTR_NAME,
+	ATTR_VAL,
+	AFTER_ATTR_VAL,
+	IDLE
+};
+
+/* Everything the state machine needs to pick up where the previous chunk left off. */
+struct Parser
+{
+	enum LH_Parser_Mode mode;
+	bool at_split; // Started by parser_init_split, so the enclosing blocks close in a later split.
+	bool failed; // Ran out of memory, the input since has been dropped.
+	struct LH_Callbacks cb;
+	void *ctx; // Handed back to every callback
+	enum State state;
+	struct TagStack tags;
+	int sub_cursor;
+	int skip;
+	char tag_name[16]; // Longer ones aren't any we know
+	bool start_tag;
+	char attr_name[128];
+	size_t attr_name_len;
+	char attr_val[2048]; // A value that spans chunks, the rest are sliced from the input.
+	struct LH_Slice tag_k;
+	struct LH_Slice tag_v;
+
+	struct LH_Element elem;
+	struct LH_Changeset changeset;
+	// Children of the open way or relation. Roles are packed end to end, each member's is as long as
+	// its role.len says; role.p is filled in when the relation closes.
+	long *refs;
+	size_t refs_n;
+	size_t refs_cap;
+	struct LH_Member *members;
+	size_t members_n;
+	size_t members_cap;
+	char *roles;
+	size_t roles_len;
+	size_t roles_cap;
+	// Slices still in use when a chunk ends are copied here before the input moves on. Text with
+	// entities in it is decoded straight into here. OSM allows 255 characters, up to 1020 bytes.
+	char kept[PARSER_KEPT][1024];
+
+	// LH_PARSER_INDEXED only
+	uint32_t *index; // Structural offsets of the current window.
+	size_t index_cap;
+	char *carry; // A tag cut off by the end of the last chunk.
+	size_t carry_len;
+	size_t carry_cap;
+	bool carry_quote; // ...ending inside an attribute value.
+};
+
+void parser_init(struct Parser *p);
+
+void parser_init_split(struct Parser *p, const struct LH_Split *split);
+
+int parser_feed(struct Parser *p, const char *buf, size_t len);
+
+bool parser_finish(const struct Parser *p);
+
+void parser_free(struct Parser *p);
+
+void elem_attr_add(struct LH_Element *elem, struct LH_Slice name, struct LH_Slice val);
+
+void changeset_attr_add(struct LH_Changeset *cs, struct LH_Slice name, struct LH_Slice val);
+
+#endif
@@ -0,0 +1,128 @@
+#include "refs.h"
+#include <string.h>
+
+static inline size_t varint_put(uint8_t *out, uint64_t v)
+{
+	size_t n = 0;
+	while (v >= 0x80) {
+		out[n++] = (uint8_t)v | 0x80;
+		v >>= 7;
+	}
+	out[n++] = (uint8_t)v;
+	return n;
+}
+
+/* Read a varint from `in`, not past `end`. Returns its length, 0 if it's cut off or too long. */
+static inline size_t varint_get(const uint8_t *in, const uint8_t *end, uint64_t *v)
+{
+	uint64_t x = 0;
+	for (size_t n = 0; n < REFS_MAX_VARINT && in + n < end; n++) {
+		x |= (uint64_t)(in[n] & 0x7F) << (7 * n);
+		if (!(in[n] & 0x80)) {
+			*v = x;
+			return n + 1;
+		}
+	}
+	return 0;
+}
+
+static inline uint64_t zigzag(const int64_t v)
+{
+	return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+}
+
+static inline int64_t unzigzag(const uint64_t v)
+{
+	return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+}
+
+/* Encode `n` refs into `out`, which has room for REFS_BOUND(n) bytes. Returns the length. */
+size_t refs_encode(uint8_t *out, const long *refs, const size_t n)
+{
+	size_t len = 0;
+	long prev = 0;
+	for (size_t i = 0; i < n; i++) {
+		len += varint_put(out + len, zigzag((int64_t)((uint64_t)refs[i] - (uint64_t)prev)));
+		prev = refs[i];
+	}
+	return len;
+}
+
+/* Decode a blob from `refs_encode` into `refs`, at most `cap` of them. Returns how many it holds,
+ * which can be more than `cap`, like snprintf. A cut-off blob ends at its last whole ref. */
+size_t refs_decode(const uint8_t *in, const size_t len, long *refs, const size_t cap)
+{
+	const uint8_t *end = in + len;
+	size_t n = 0;
+	long prev = 0;
+	uint64_t v;
+	size_t used;
+	while (in < end && (used = varint_get(in, end, &v)) > 0) {
+		prev = (long)((uint64_t)prev + (uint64_t)unzigzag(v));
+		if (n < cap)
+			refs[n] = prev;
+		n++;
+		in += used;
+	}
+	return n;
+}
+
+/* A member's type in the low two bits of its role length. */
+static inline unsigned member_type_bits(const enum LH_Element_Type type)
+{
+	return type == LH_NODE ? 0 : type == LH_WAY ? 1 : type == LH_RELATION ? 2 : 3;
+}
+
+static const enum LH_Element_Type member_types[4] = {LH_NODE, LH_WAY, LH_RELATION, LH_NOT};
+
+/* Bytes `members_encode` can write for these members. */
+size_t members_bound(const struct LH_Member *members, const size_t n)
+{
+	size_t len = 0;
+	for (size_t i = 0; i < n; i++)
+		len += 2 * REFS_MAX_VARINT + members[i].role.len;
+	return len;
+}
+
+/* Encode `n` members into `out`, which has room for `members_bound` bytes. Each is its ref delta,
+ * then its role length and type together, then the role. Returns the length. */
+size_t members_encode(uint8_t *out, const struct LH_Member *members, const size_t n)
+{
+	size_t len = 0;
+	long prev = 0;
+	for (size_t i = 0; i < n; i++) {
+		const struct LH_Member *m = &members[i];
+		len += varint_put(out + len, zigzag((int64_t)((uint64_t)m->ref - (uint64_t)prev)));
+		len += varint_put(out + len, (uint64_t)m->role.len << 2 | member_type_bits(m->type));
+		if (m->role.len > 0)
+			memcpy(out + len, m->role.p, m->role.len);
+		len += m->role.len;
+		prev = m->ref;
+	}
+	return len;
+}
+
+/* Decode a blob from `members_encode`, at most `cap` members, with roles pointing into `in`. Returns
+ * how many it holds, like `refs_decode`. */
+size_t members_decode(const uint8_t *in, const size_t len, struct LH_Member *members, const size_t cap)
+{
+	const uint8_t *end = in + len;
+	size_t n = 0;
+	long prev = 0;
+	while (in < end) {
+		uint64_t delta, role;
+		size_t used = varint_get(in, end, &delta);
+		if (used == 0)
+			break;
+		const size_t used_role = varint_get(in + used, end, &role);
+		if (used_role == 0 || (uint64_t)(end - in - used - used_role) < role >> 2)
+			break;
+		used += used_role;
+		prev = (long)((uint64_t)prev + (uint64_t)unzigzag(delta));
+		if (n < cap)
+			members[n] = (struct LH_Member){member_types[role & 3], prev, {(const char *)in + used, role >> 2}};
+		n++;
+		in += used + (role >> 2);
+	}
+	return n;
+}
@@ -0,0 +1,29 @@
+#ifndef REFS_H
+#define REFS_H
+
+#include "export.h"
+#include "lighthouse.h"
+#include <stdint.h>
+#include <stdlib.h>
+
+/* Way node refs and relation members are stored as blobs. Each ref is the difference from the one
+ * before it, zigzagged so that small steps either way are small numbers, as an LEB128 varint. The
+ * nodes of a way are mostly close in id, so a ref takes 1-3 bytes instead of 8. */
+
+/* Longest LEB128 varint, for 64 bits. */
+#define REFS_MAX_VARINT 10
+
+/* Bytes `refs_encode` can write for `n` refs. */
+#define REFS_BOUND(n) ((n) * REFS_MAX_VARINT)
+
+LH_EXPORT size_t refs_encode(uint8_t *out, const long *refs, size_t n);
+
+LH_EXPORT size_t refs_decode(const uint8_t *in, size_t len, long *refs, size_t cap);
+
+LH_EXPORT size_t members_bound(const struct LH_Member *members, size_t n);
+
+LH_EXPORT size_t members_encode(uint8_t *out, const struct LH_Member *members, size_t n);
+
+LH_EXPORT size_t members_decode(const uint8_t *in, size_t len, struct LH_Member *members, size_t cap);
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef SCAN_H
+#define SCAN_H
+
+/* Vectorised searches for the parser's structural bytes. AVX2 is used when the build enables it
+ * (e.g. CFLAGS += -mavx2 or -march=native), SSE2 on any x86-64, plain loops elsewhere. */
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/* First `c` in [p, end), or `end` if there is none. */
+static inline const char *scan_find(const char *p, const char *end, const char c)
+{
+#if defined(__AVX2__)
+	const __m256i v32 = _mm256_set1_epi8(c);
+	for (; end - p >= 32; p += 32) {
+		const __m256i x = _mm256_loadu_si256((const __m256i *)p);
+		const unsigned m = _mm256_movemask_epi8(_mm256_cmpeq_epi8(x, v32));
+		if (m)
+			return p + __builtin_ctz(m);
+	}
+#endif
+#if defined(__SSE2__)
+	const __m128i v16 = _mm_set1_epi8(c);
+	for (; end - p >= 16; p += 16) {
+		const __m128i x = _mm_loadu_si128((const __m128i *)p);
+		const unsigned m = _mm_movemask_epi8(_mm_cmpeq_epi8(x, v16));
+		if (m)
+			return p + __builtin_ctz(m);
+	}
+#endif
+	for (; p < end; p++)
+		if (*p == c)
+			return p;
+	return end;
+}
+
+#endif
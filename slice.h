@@ -0,0 +1,20 @@
+#ifndef SLICE_H
+#define SLICE_H
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* A string that isn't NUL-terminated, usually pointing straight into the input. */
+struct LH_Slice
+{
+	const char *p;
+	size_t len;
+};
+
+static inline bool lh_slice_eq(const struct LH_Slice s, const char *str)
+{
+	return s.len == strlen(str) && memcmp(s.p, str, s.len) == 0;
+}
+
+#endif
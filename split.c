@@ -0,0 +1,102 @@
+#define _GNU_SOURCE // memrchr
+#include "split.h"
+#include <stdbool.h>
+#include <string.h>
+
+static bool is_name_end(const char c)
+{
+	return c == ' ' || c == '>' || c == '/' || c == '\t' || c == '\n' || c == '\r';
+}
+
+/* Whether `p` holds `name` followed by the end of a tag name. */
+static bool has_name(const char *p, const char *end, const char *name)
+{
+	const size_t n = strlen(name);
+	return (size_t)(end - p) > n && memcmp(p, name, n) == 0 && is_name_end(p[n]);
+}
+
+static bool is_action(const char *p, const char *end)
+{
+	return has_name(p, end, "create") || has_name(p, end, "modify") || has_name(p, end, "delete");
+}
+
+/* Top-level elements of changeset dumps and .osm/.osc files. '<' can't appear unescaped
+ * in attribute values or text, so any '<' followed by one of these starts such an element. */
+static bool is_boundary(const char *p, const char *end)
+{
+	return has_name(p + 1, end, "changeset") || has_name(p + 1, end, "node") ||
+	       has_name(p + 1, end, "way") || has_name(p + 1, end, "relation") || is_action(p + 1, end);
+}
+
+static size_t next_boundary(const char *buf, const size_t len, const size_t from)
+{
+	const char *end = buf + len;
+	for (const char *p = buf + from; (p = memchr(p, '<', end - p)) != NULL; p++)
+		if (is_boundary(p, end))
+			return p - buf;
+	return len;
+}
+
+static void context_push(struct LH_Split *s, const char *name, const size_t n)
+{
+	memcpy(s->context[s->depth], name, n);
+	s->context[s->depth][n] = '\0';
+	s->depth++;
+}
+
+/* The root element, and for .osc files the <create>/<modify>/<delete> block `at` sits in. */
+static void find_context(const char *buf, const size_t len, const size_t at, struct LH_Split *s)
+{
+	const char *end = buf + len;
+	s->depth = 0;
+
+	// Root: the first start-tag that isn't <?xml ...?> or <!-- -->.
+	const char *root = buf;
+	while ((root = memchr(root, '<', end - root)) != NULL && (root[1] == '?' || root[1] == '!'))
+		root++;
+	if (!root || root >= buf + at)
+		return;
+	size_t n = 0;
+	while (root + 1 + n < end && !is_name_end(root[1 + n]) && n < sizeof(s->context[0]) - 1)
+		n++;
+	context_push(s, root + 1, n);
+	if (!has_name(root + 1, end, "osmChange"))
+		return;
+
+	// Walk back to the nearest action tag, an end-tag means we're between blocks.
+	for (const char *p = buf + at; (p = memrchr(buf, '<', p - buf)) != NULL;) {
+		if (p[1] == '/' && is_action(p + 2, end))
+			return;
+		if (is_action(p + 1, end)) {
+			context_push(s, p + 1, 6); // "create", "modify" and "delete" are all 6 long.
+			return;
+		}
+	}
+}
+
+/* Cut `buf` into at most `n` runs of roughly equal size, each starting on a top-level element
+ * (<changeset>, <node>, <way>, <relation> or an .osc action block) so that it can be parsed
+ * independently once the parser is seeded with its context. Returns the number of splits written. */
+size_t lh_split_input(const char *buf, const size_t len, const size_t n, struct LH_Split *splits)
+{
+	size_t count = 0;
+	size_t start = 0;
+	for (size_t k = 1; k <= n && start < len; k++) {
+		size_t next = len;
+		if (k < n) {
+			size_t target = len / n * k;
+			if (target <= start)
+				target = start + 1;
+			next = next_boundary(buf, len, target);
+		}
+		struct LH_Split *s = &splits[count++];
+		s->offset = start;
+		s->len = next - start;
+		if (start == 0)
+			s->depth = 0; // The first run sees the document from the top.
+		else
+			find_context(buf, len, start, s);
+		start = next;
+	}
+	return count;
+}
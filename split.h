@@ -0,0 +1,21 @@
+#ifndef SPLIT_H
+#define SPLIT_H
+
+#include "export.h"
+#include <stdlib.h>
+
+#define LH_SPLIT_MAX_CONTEXT 2
+
+/* A run of a document that starts on an element boundary and can be parsed on its own. */
+struct LH_Split
+{
+	size_t offset;
+	size_t len;
+	// Start-tags still open at `offset`, outermost first, e.g. "osmChange" -> "modify".
+	char context[LH_SPLIT_MAX_CONTEXT][16];
+	size_t depth;
+};
+
+LH_EXPORT size_t lh_split_input(const char *buf, size_t len, size_t n, struct LH_Split *splits);
+
+#endif
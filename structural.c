@@ -0,0 +1,75 @@
+#include "structural.h"
+#include <string.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/* Bitmaps of the quotes and of the other structural bytes (< > = /) in a 64-byte block. */
+static inline void classify_block(const char *b, uint64_t *quote, uint64_t *other)
+{
+#if defined(__AVX2__)
+	const __m256i q = _mm256_set1_epi8('"'), lt = _mm256_set1_epi8('<'), gt = _mm256_set1_epi8('>'),
+		      eq = _mm256_set1_epi8('='), sl = _mm256_set1_epi8('/');
+	uint64_t qm = 0, om = 0;
+	for (int i = 0; i < 2; i++) {
+		const __m256i x = _mm256_loadu_si256((const __m256i *)(b + 32 * i));
+		const __m256i o = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(x, lt), _mm256_cmpeq_epi8(x, gt)),
+						  _mm256_or_si256(_mm256_cmpeq_epi8(x, eq), _mm256_cmpeq_epi8(x, sl)));
+		qm |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, q)) << (32 * i);
+		om |= (uint64_t)(uint32_t)_mm256_movemask_epi8(o) << (32 * i);
+	}
+	*quote = qm;
+	*other = om;
+#elif defined(__SSE2__)
+	const __m128i q = _mm_set1_epi8('"'), lt = _mm_set1_epi8('<'), gt = _mm_set1_epi8('>'),
+		      eq = _mm_set1_epi8('='), sl = _mm_set1_epi8('/');
+	uint64_t qm = 0, om = 0;
+	for (int i = 0; i < 4; i++) {
+		const __m128i x = _mm_loadu_si128((const __m128i *)(b + 16 * i));
+		const __m128i o = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(x, lt), _mm_cmpeq_epi8(x, gt)),
+					       _mm_or_si128(_mm_cmpeq_epi8(x, eq), _mm_cmpeq_epi8(x, sl)));
+		qm |= (uint64_t)(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(x, q)) << (16 * i);
+		om |= (uint64_t)(uint32_t)_mm_movemask_epi8(o) << (16 * i);
+	}
+	*quote = qm;
+	*other = om;
+#else
+	uint64_t qm = 0, om = 0;
+	for (int i = 0; i < 64; i++) {
+		const char c = b[i];
+		qm |= (uint64_t)(c == '"') << i;
+		om |= (uint64_t)(c == '<' || c == '>' || c == '=' || c == '/') << i;
+	}
+	*quote = qm;
+	*other = om;
+#endif
+}
+
+/* Stage 1: write the offsets of every < > = / and quote to `pos` (room for `len` entries). Which
+ * of them are markup is left to stage 2: a quote only opens a value inside a tag, text can have its
+ * own. Returns how many there are. */
+size_t structural_index(const char *buf, const size_t len, uint32_t *pos)
+{
+	size_t n = 0;
+	for (size_t base = 0; base < len; base += 64) {
+		const char *b = buf + base;
+		char tail[64];
+		if (len - base < 64) {
+			memset(tail, ' ', sizeof(tail));
+			memcpy(tail, b, len - base);
+			b = tail;
+		}
+		uint64_t quote, other;
+		classify_block(b, &quote, &other);
+
+		uint64_t bits = quote | other;
+		while (bits) {
+			pos[n++] = base + __builtin_ctzll(bits);
+			bits &= bits - 1;
+		}
+	}
+	return n;
+}
@@ -0,0 +1,9 @@
+#ifndef STRUCTURAL_H
+#define STRUCTURAL_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+size_t structural_index(const char *buf, size_t len, uint32_t *pos);
+
+#endif
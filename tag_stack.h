@@ -0,0 +1,43 @@
+#ifndef TAG_STACK_H
+#define TAG_STACK_H
+
+#include "names.h"
+#include <stdlib.h>
+
+#define TAG_STACK_DEPTH 20
+
+/* The start-tags still open, as name IDs. Tags nested deeper than TAG_STACK_DEPTH are counted but
+ * read back as NAME_UNKNOWN. */
+struct TagStack
+{
+	unsigned char ids[TAG_STACK_DEPTH];
+	size_t depth;
+};
+
+static inline void tstack_push(struct TagStack *stack, const enum Name id)
+{
+	if (stack->depth < TAG_STACK_DEPTH)
+		stack->ids[stack->depth] = id;
+	stack->depth++;
+}
+
+/* The tag `n_below` under the top, NAME_UNKNOWN if there isn't one. */
+static inline enum Name tstack_n(const struct TagStack *stack, const size_t n_below)
+{
+	if (n_below >= stack->depth || stack->depth - n_below > TAG_STACK_DEPTH)
+		return NAME_UNKNOWN;
+	return stack->ids[stack->depth - 1 - n_below];
+}
+
+static inline enum Name tstack_top(const struct TagStack *stack)
+{
+	return tstack_n(stack, 0);
+}
+
+static inline void tstack_pop(struct TagStack *stack)
+{
+	if (stack->depth > 0)
+		stack->depth--;
+}
+
+#endif
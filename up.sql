@@ -5,13 +5,19 @@ CREATE TABLE "changeset_tags" (
 	PRIMARY KEY("changeset","k")
 );
 
+-- The latest name of each user seen in changesets and elements.
+CREATE TABLE "users" (
+	"uid"  INTEGER,
+	"name" TEXT NOT NULL,
+	PRIMARY KEY("uid")
+);
+
 CREATE TABLE "changesets" (
 	"id"	     INTEGER,
-	"created_at" TEXT NOT NULL,
-	"closed_at"  TEXT,
+	"created_at" INTEGER NOT NULL, -- Seconds since 1970 when loaded with -t, ISO 8601 text otherwise
+	"closed_at"  INTEGER,
 	"open"	     INTEGER NOT NULL,
-	"user"	     TEXT NOT NULL,
-	"uid"	     INTEGER NOT NULL,
+	"uid"	     INTEGER NOT NULL REFERENCES "users",
 	"min_lat"    REAL NOT NULL,
 	"max_lat"    REAL NOT NULL,
 	"min_lon"    REAL NOT NULL,
@@ -20,11 +26,57 @@ CREATE TABLE "changesets" (
 	PRIMARY KEY("id")
 );
 
+-- Tag keys and values of nodes, ways and relations, each distinct string once.
+CREATE TABLE "keys" (
+	"id" INTEGER PRIMARY KEY,
+	"k"  TEXT NOT NULL UNIQUE
+);
+
+CREATE TABLE "vals" (
+	"id" INTEGER PRIMARY KEY,
+	"v"  TEXT NOT NULL UNIQUE
+);
+
+CREATE TABLE "node_tags" (
+	"id"	  INTEGER,
+	"version" INTEGER,
+	"k"	  INTEGER NOT NULL REFERENCES "keys",
+	"v"	  INTEGER NOT NULL REFERENCES "vals",
+	PRIMARY KEY("id","version","k")
+) WITHOUT ROWID;
+
+CREATE TABLE "way_tags" (
+	"id"	  INTEGER,
+	"version" INTEGER,
+	"k"	  INTEGER NOT NULL REFERENCES "keys",
+	"v"	  INTEGER NOT NULL REFERENCES "vals",
+	PRIMARY KEY("id","version","k")
+) WITHOUT ROWID;
+
+CREATE TABLE "relation_tags" (
+	"id"	  INTEGER,
+	"version" INTEGER,
+	"k"	  INTEGER NOT NULL REFERENCES "keys",
+	"v"	  INTEGER NOT NULL REFERENCES "vals",
+	PRIMARY KEY("id","version","k")
+) WITHOUT ROWID;
+
+-- The "action" of nodes, ways and relations, see enum OSM_Action. The *_actions views show it by name.
+CREATE TABLE "actions" (
+	"code" INTEGER,
+	"name" TEXT NOT NULL,
+	PRIMARY KEY("code")
+);
+
+INSERT INTO "actions" VALUES (0, 'none'), (1, 'create'), (2, 'modify'), (3, 'delete');
+
 CREATE TABLE "nodes" (
 	"id"	    INTEGER,
 	"version"   INTEGER,
 	"changeset" INTEGER NOT NULL,
-	"action"    TEXT NOT NULL,
+	"timestamp" INTEGER NOT NULL, -- Seconds since 1970
+	"uid"	    INTEGER NOT NULL REFERENCES "users",
+	"action"    INTEGER NOT NULL REFERENCES "actions",
 	PRIMARY KEY("version","id")
 );
 
@@ -32,7 +84,10 @@ CREATE TABLE "relations" (
 	"id"	    INTEGER,
 	"version"   INTEGER,
 	"changeset" INTEGER NOT NULL,
-	"action"    TEXT NOT NULL,
+	"timestamp" INTEGER NOT NULL,
+	"uid"	    INTEGER NOT NULL REFERENCES "users",
+	"action"    INTEGER NOT NULL REFERENCES "actions",
+	"members"   BLOB NOT NULL, -- Per member: ref delta, role length << 2 | type (node, way, relation), role; see refs.h
 	PRIMARY KEY("version","id")
 );
 
@@ -40,6 +95,28 @@ CREATE TABLE "ways" (
 	"id"	    INTEGER,
 	"version"   INTEGER,
 	"changeset" INTEGER NOT NULL,
-	"action"    TEXT NOT NULL,
+	"timestamp" INTEGER NOT NULL,
+	"uid"	    INTEGER NOT NULL REFERENCES "users",
+	"action"    INTEGER NOT NULL REFERENCES "actions",
+	"nodes"	    BLOB NOT NULL, -- Node ids as zigzag varint deltas, see refs.h
 	PRIMARY KEY("version","id")
 );
+
+-- Which ways reference each node, derived from ways.nodes when loaded with -r.
+CREATE TABLE "node_ways" (
+	"node" INTEGER,
+	"way"  INTEGER,
+	PRIMARY KEY("node","way")
+) WITHOUT ROWID;
+
+CREATE VIEW "node_actions" AS
+	SELECT n."id", n."version", n."changeset", n."timestamp", n."uid", a."name" AS "action"
+	FROM "nodes" n JOIN "actions" a ON a."code" = n."action";
+
+CREATE VIEW "way_actions" AS
+	SELECT w."id", w."version", w."changeset", w."timestamp", w."uid", a."name" AS "action"
+	FROM "ways" w JOIN "actions" a ON a."code" = w."action";
+
+CREATE VIEW "relation_actions" AS
+	SELECT r."id", r."version", r."changeset", r."timestamp", r."uid", a."name" AS "action"
+	FROM "relations" r JOIN "actions" a ON a."code" = r."action";